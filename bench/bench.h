@@ -0,0 +1,11 @@
+#ifndef INCLUDED__csp__bench__bench_h
+#define INCLUDED__csp__bench__bench_h
+
+// Benchmark suites, run in order by bench/main.cc.
+void channel_benchmarks();
+void layout_benchmarks();
+void policy_benchmarks();
+void spawn_benchmarks();
+void timer_benchmarks();
+
+#endif // INCLUDED__csp__bench__bench_h
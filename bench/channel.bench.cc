@@ -1,6 +1,8 @@
-#define ANKERL_NANOBENCH_IMPLEMENT
+#include "bench.h"
+
 #include <nanobench/nanobench.h>
 
+#include <csp/buffer.h>
 #include <csp/microthread.h>
 
 #include <algorithm>
@@ -13,7 +15,7 @@ using namespace csp;
 // and nanobench divides elapsed time by BATCH to get per-op cost.
 static constexpr int BATCH = 50'000;
 
-int main() {
+void channel_benchmarks() {
     ankerl::nanobench::Bench bench;
     bench.warmup(3).minEpochIterations(3);
 
@@ -33,6 +35,51 @@ int main() {
         ankerl::nanobench::doNotOptimizeAway(sum);
     });
 
+    // --- Same, with run-queue and channel locking switched off ---
+    {
+        runtime_options opts;
+        opts.single_threaded = true;
+        csp::init_runtime(opts);
+        bench.batch(BATCH).run("send/recv (single_threaded)", [&] {
+            channel<int> ch;
+            csp::spawn([w = +ch] {
+                for (int i = 0; i < BATCH; i++) w << i;
+            });
+            int sum = 0;
+            csp::spawn([r = -ch, &sum] {
+                int n;
+                for (int i = 0; i < BATCH; i++) { r >> n; sum += n; }
+            });
+            ch.release();
+            csp::schedule();
+            ankerl::nanobench::doNotOptimizeAway(sum);
+        });
+        csp::shutdown_runtime();
+    }
+
+    // --- Buffered: a native channel<int>(64) versus a spawn_buffer
+    // microthread between two unbuffered channels ---
+    static constexpr size_t CAPACITY = 64;
+    auto pipe = [&](channel<int> ch) {
+        csp::spawn([w = +ch] {
+            for (int i = 0; i < BATCH; i++) w << i;
+        });
+        int sum = 0;
+        csp::spawn([r = -ch, &sum] {
+            int n;
+            for (int i = 0; i < BATCH; i++) { r >> n; sum += n; }
+        });
+        ch.release();
+        csp::schedule();
+        ankerl::nanobench::doNotOptimizeAway(sum);
+    };
+    bench.batch(BATCH).run("send/recv buffered(64)", [&] {
+        pipe(channel<int>(CAPACITY));
+    });
+    bench.batch(BATCH).run("send/recv spawn_buffer(64)", [&] {
+        pipe(chan::spawn_buffer<int>(CAPACITY));
+    });
+
     // --- prialt with 2 channels ---
     bench.batch(2 * BATCH).run("prialt/2ch", [&] {
         channel<int> c0, c1;
@@ -118,6 +165,58 @@ int main() {
         ankerl::nanobench::doNotOptimizeAway(sum);
     });
 
+    // --- Many channels: rebuilding an alt each time vs a select_set ---
+    static constexpr int M = 64, PER = BATCH / M;
+    bench.batch(M * PER).run("alt/64ch", [&] {
+        std::vector<channel<int>> chs(M);
+        std::vector<reader<int>> rs;
+        for (auto & ch : chs) {
+            csp::spawn([w = +ch] {
+                for (int i = 0; i < PER; i++) w << i;
+            });
+            rs.push_back(-ch);
+        }
+        int sum = 0;
+        csp::spawn([&sum, rs] {
+            int n;
+            for (int i = 0; i < M * PER; i++) {
+                std::vector<action> actions;
+                for (auto & r : rs) actions.push_back(r >> n);
+                alt(actions);
+                sum += n;
+            }
+        });
+        chs.clear();
+        rs.clear();
+        csp::schedule();
+        ankerl::nanobench::doNotOptimizeAway(sum);
+    });
+
+    bench.batch(M * PER).run("select_set/64ch", [&] {
+        std::vector<channel<int>> chs(M);
+        std::vector<reader<int>> rs;
+        for (auto & ch : chs) {
+            csp::spawn([w = +ch] {
+                for (int i = 0; i < PER; i++) w << i;
+            });
+            rs.push_back(-ch);
+        }
+        int sum = 0;
+        csp::spawn([&sum, rs] {
+            int n;
+            select_set set;
+            for (auto & r : rs) set.add(r >> n);
+            for (int i = 0; i < M * PER; i++) {
+                set.wait();
+                sum += n;
+            }
+        });
+        chs.clear();
+        rs.clear();
+        csp::schedule();
+        ankerl::nanobench::doNotOptimizeAway(sum);
+    });
+
     // --- Isolated: RNG + shuffle overhead (no channel work) ---
     bench.batch(1).run("rng+shuffle/2", [&] {
         csp_chanop ops[2] = {};
@@ -134,6 +233,4 @@ int main() {
         std::shuffle(ops, ops + 8, rng);
         ankerl::nanobench::doNotOptimizeAway(ops[0]);
     });
-
-    return 0;
 }
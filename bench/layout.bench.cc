@@ -0,0 +1,102 @@
+#include "bench.h"
+
+#include <nanobench/nanobench.h>
+
+#include <csp/internal/runtime.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace csp;
+using namespace csp::detail;
+
+// False-sharing benchmarks for the Processor/Runtime layout.
+//
+// Each case times one thread bumping a field while a second thread bumps
+// a field that a *different* party owns in the real runtime, once on the
+// real struct and once on a packed replica of the old layout. On a
+// machine with more than one core the packed rows should be markedly
+// slower; on one core the rows are equal. Run under
+// `perf c2c record ./build/csp_bench` to see the HITM counts behind the
+// difference.
+
+static constexpr int BATCH = 1'000'000;
+
+namespace {
+
+    // The old Processor layout: run queue and timer state (written by
+    // thieves and remote timer firers) packed in with the owner's.
+    struct PackedProcessor {
+        std::atomic<int> queued{0};
+        std::atomic<uint64_t> deadline_dispatches{0};
+        std::atomic<uint64_t> remote_timer_fires{0};
+    };
+
+    // The old Runtime layout: global queue state next to live_gs.
+    struct PackedRuntime {
+        std::atomic<int> global_len{0};
+        std::atomic<int> live_gs{0};
+    };
+
+    // Time BATCH relaxed increments of *mine while another thread keeps
+    // incrementing *theirs.
+    template <typename A, typename B>
+    void contend(ankerl::nanobench::Bench & bench, char const * name, A * mine, B * theirs) {
+        std::atomic<bool> stop{false};
+        std::thread other([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                theirs->fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        bench.batch(BATCH).run(name, [&] {
+            for (int i = 0; i < BATCH; ++i) {
+                mine->fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        stop = true;
+        other.join();
+    }
+
+}
+
+void layout_benchmarks() {
+    ankerl::nanobench::Bench bench;
+    bench.title("false sharing").warmup(3).minEpochIterations(3);
+
+    // --- Processor: owner's statistics vs thieves and remote timers ---
+    {
+        auto p = std::make_unique<Processor>(0);
+        contend(bench, "Processor owner vs run queue", &p->deadline_dispatches, &p->queued);
+        contend(bench, "Processor owner vs remote timers", &p->deadline_dispatches, &p->remote_timer_fires);
+        PackedProcessor packed;
+        contend(bench, "packed owner vs run queue", &packed.deadline_dispatches, &packed.queued);
+        contend(bench, "packed owner vs remote timers", &packed.deadline_dispatches, &packed.remote_timer_fires);
+    }
+
+    // --- Runtime: global queue length vs live microthread count ---
+    {
+        auto rt = std::make_unique<Runtime>();
+        contend(bench, "Runtime global queue vs live_gs", &rt->global_len, &rt->live_gs);
+        PackedRuntime packed;
+        contend(bench, "packed global queue vs live_gs", &packed.global_len, &packed.live_gs);
+    }
+
+    // --- End to end: chatty pairs spread across processors ---
+    static constexpr int PAIRS = 4;
+    static constexpr int MSGS = 20'000;
+    csp::init_runtime(PAIRS + 1);
+    bench.batch(PAIRS * MSGS).run("M:N ping-pong pairs", [&] {
+        for (int k = 0; k < PAIRS; ++k) {
+            channel<int> ping, pong;
+            csp::spawn([r = --ping, w = ++pong] {
+                for (int v; r >> v;) w << v;
+            });
+            csp::spawn([w = ++ping, r = --pong] {
+                int v;
+                for (int i = 0; i < MSGS; ++i) { w << i; r >> v; }
+            });
+        }
+        csp::schedule();
+    });
+    csp::shutdown_runtime();
+}
@@ -0,0 +1,13 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench/nanobench.h>
+
+#include "bench.h"
+
+int main() {
+    channel_benchmarks();
+    layout_benchmarks();
+    spawn_benchmarks();
+    policy_benchmarks();
+    timer_benchmarks();
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "bench.h"
+
+#include <nanobench/nanobench.h>
+
+#include <csp/microthread.h>
+#include <csp/scheduler.h>
+
+#include <atomic>
+#include <string>
+
+using namespace csp;
+
+// Run-queue policy matrix: each built-in policy against a single-processor
+// ping-pong (csp_run's pick), M:N ping-pong pairs (wakeups through the
+// global queue) and a yield storm on one processor with idle thieves
+// (local picks and steals).
+
+static constexpr int MSGS = 20'000;
+static constexpr int PAIRS = 4;
+static constexpr int YIELDERS = 64;
+static constexpr int YIELDS = 200;
+
+namespace {
+
+    void ping_pong(int msgs) {
+        channel<int> ping, pong;
+        csp::spawn([r = --ping, w = ++pong] {
+            for (int v; r >> v;) w << v;
+        });
+        csp::spawn([w = ++ping, r = --pong, msgs] {
+            int v;
+            for (int i = 0; i < msgs; ++i) { w << i; r >> v; }
+        });
+    }
+
+}
+
+void policy_benchmarks() {
+    ankerl::nanobench::Bench bench;
+    bench.title("run-queue policy").warmup(1).minEpochIterations(10);
+
+    sched_policy const policies[] = {
+        sched_policy::fifo, sched_policy::lifo, sched_policy::edf,
+    };
+
+    for (auto policy : policies) {
+        std::string name = make_queue_policy(policy)->name();
+        runtime_options opts;
+        opts.policy = policy;
+
+        opts.num_procs = 1;
+        csp::init_runtime(opts);
+        bench.batch(MSGS).run("ping-pong/" + name, [&] {
+            ping_pong(MSGS);
+            csp::schedule();
+        });
+        csp::shutdown_runtime();
+
+        opts.num_procs = PAIRS + 1;
+        csp::init_runtime(opts);
+        bench.batch(PAIRS * MSGS).run("M:N pairs/" + name, [&] {
+            for (int k = 0; k < PAIRS; ++k) {
+                ping_pong(MSGS);
+            }
+            csp::schedule();
+        });
+
+        bench.batch(YIELDERS * YIELDS).run("yield storm/" + name, [&] {
+            std::atomic<int> done{0};
+            for (int k = 0; k < YIELDERS; ++k) {
+                csp::spawn(on_processor(1), [&] {
+                    for (int i = 0; i < YIELDS; ++i) {
+                        csp_yield();
+                    }
+                    ++done;
+                });
+            }
+            csp::schedule();
+            ankerl::nanobench::doNotOptimizeAway(done.load());
+        });
+        csp::shutdown_runtime();
+    }
+}
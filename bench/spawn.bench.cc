@@ -0,0 +1,71 @@
+#include "bench.h"
+
+#include <nanobench/nanobench.h>
+
+#include <csp/count.h>
+#include <csp/map.h>
+#include <csp/microthread.h>
+#include <csp/where.h>
+
+#include <atomic>
+#include <string>
+
+using namespace csp;
+
+// Spawn placement under M:N: a chan::spawn_* pipeline built from inside a
+// microthread (each stage talks to the one that spawned it), and a batch
+// of independent workers (which want to be spread out).
+
+static constexpr int N = 20'000;
+static constexpr int WORKERS = 64;
+
+void spawn_benchmarks() {
+    ankerl::nanobench::Bench bench;
+    bench.title("spawn placement").warmup(1).minEpochIterations(10);
+
+    struct { char const * name; placement where; } const placements[] = {
+        {"global", placement::global},
+        {"local",  placement::local},
+        {"spread", placement::spread},
+    };
+
+    for (auto const & pl : placements) {
+        runtime_options opts;
+        opts.num_procs = 4;
+        opts.spawn_placement = pl.where;
+        csp::init_runtime(opts);
+
+        bench.batch(N).run(std::string("pipeline/") + pl.name, [&] {
+            long sum = 0;
+            csp::spawn([&] {
+                auto r = chan::spawn_count(0, N);
+                auto m = chan::spawn_map<int>(std::move(r), [](int x) { return x + 1; });
+                auto w = chan::spawn_where(std::move(m), [](int x) { return x % 3 != 0; });
+                for (int v; w >> v;) {
+                    sum += v;
+                }
+            });
+            csp::schedule();
+            ankerl::nanobench::doNotOptimizeAway(sum);
+        });
+
+        bench.batch(WORKERS).run(std::string("independent/") + pl.name, [&] {
+            std::atomic<long> total{0};
+            csp::spawn([&] {
+                for (int k = 0; k < WORKERS; ++k) {
+                    csp::spawn([&] {
+                        long x = 0;
+                        for (int i = 0; i < 10'000; ++i) {
+                            ankerl::nanobench::doNotOptimizeAway(x += i);
+                        }
+                        total += x;
+                    });
+                }
+            });
+            csp::schedule();
+            ankerl::nanobench::doNotOptimizeAway(total.load());
+        });
+
+        csp::shutdown_runtime();
+    }
+}
@@ -0,0 +1,155 @@
+#include "bench.h"
+
+#include <nanobench/nanobench.h>
+
+#include <csp/internal/timer_wheel.h>
+#include <csp/timer.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace csp::detail;
+
+// Guarded receives: every message arrives well before its timeout, so
+// these measure arming and dropping the timeout — an after() microthread
+// versus a timeout() operand's timer entry.
+
+static constexpr int GUARDED = 10'000;
+static constexpr auto TIMEOUT = std::chrono::milliseconds(10);
+
+// Pending sleeps: insert N timers with deadlines spread over ten seconds,
+// then advance the clock in 1ms steps until all have fired, as a worker's
+// fire_timers would.  The wheel runs at its default 100us resolution; the
+// heap replica is the std::priority_queue each processor used before.
+
+static constexpr int64_t SPAN_NS = 10'000'000'000;
+static constexpr int64_t STEP_NS = 1'000'000;
+
+// Staggered sleeps: SLEEPERS microthreads on one processor sleep until
+// deadlines 100us apart, with and without timer slack.  Time per sleep
+// is mostly the sleeping itself; the wakeups line after the table counts
+// how often the idle processor woke to fire them (timer_wakeups).
+
+static constexpr int SLEEPERS = 200;
+static constexpr auto STAGGER = std::chrono::microseconds(100);
+
+namespace {
+
+    using HeapEntry = std::pair<int64_t, TimerNode *>;
+    using Heap = std::priority_queue<HeapEntry, std::vector<HeapEntry>,
+                                     std::greater<HeapEntry>>;
+
+    std::vector<int64_t> deadlines(int n) {
+        std::mt19937_64 rng(n);
+        std::uniform_int_distribution<int64_t> dist(0, SPAN_NS);
+        std::vector<int64_t> d(n);
+        for (auto& x : d) {
+            x = SPAN_NS + dist(rng);    // Clear of the wheel's starting tick
+        }
+        return d;
+    }
+
+}
+
+void timer_benchmarks() {
+    ankerl::nanobench::Bench bench;
+    bench.title("pending sleeps").warmup(1).minEpochIterations(1);
+
+    for (int n : {10'000, 100'000, 1'000'000}) {
+        auto d = deadlines(n);
+        std::vector<TimerNode> nodes(n);
+
+        bench.batch(n).run("wheel/" + std::to_string(n), [&] {
+            TimerWheel wheel;
+            wheel.expire(SPAN_NS, [](TimerNode *) { });
+            for (int i = 0; i < n; ++i) {
+                wheel.add(&nodes[i], d[i]);
+            }
+            size_t fired = 0;
+            for (int64_t now = SPAN_NS; !wheel.empty(); now += STEP_NS) {
+                wheel.expire(now, [&](TimerNode *) { ++fired; });
+            }
+            ankerl::nanobench::doNotOptimizeAway(fired);
+        });
+
+        bench.batch(n).run("heap/" + std::to_string(n), [&] {
+            Heap heap;
+            for (int i = 0; i < n; ++i) {
+                heap.push({d[i], &nodes[i]});
+            }
+            size_t fired = 0;
+            for (int64_t now = SPAN_NS; !heap.empty(); now += STEP_NS) {
+                while (!heap.empty() && heap.top().first <= now) {
+                    heap.pop();
+                    ++fired;
+                }
+            }
+            ankerl::nanobench::doNotOptimizeAway(fired);
+        });
+    }
+
+    ankerl::nanobench::Bench guarded;
+    guarded.title("guarded receive").warmup(1).minEpochIterations(3);
+
+    // alt_once(r, n) does one guarded receive into n.
+    auto receive = [](auto alt_once) {
+        csp::channel<int> ch;
+        csp::spawn([w = +ch] {
+            for (int i = 0; i < GUARDED; i++) w << i;
+        });
+        int sum = 0;
+        csp::spawn([r = -ch, &sum, alt_once] {
+            int n = 0;
+            for (int i = 0; i < GUARDED; i++) {
+                if (alt_once(r, n) == 1) sum += n;
+            }
+        });
+        ch.release();
+        csp::schedule();
+        ankerl::nanobench::doNotOptimizeAway(sum);
+    };
+
+    guarded.batch(GUARDED).run("alt with after()", [&] {
+        receive([](csp::reader<int> const & r, int & n) {
+            auto timeout = csp::after(TIMEOUT);
+            return csp::alt(r >> n, timeout >> csp::poke);
+        });
+    });
+    guarded.batch(GUARDED).run("alt with timeout()", [&] {
+        receive([](csp::reader<int> const & r, int & n) {
+            return csp::alt(r >> n, csp::timeout(TIMEOUT));
+        });
+    });
+
+    ankerl::nanobench::Bench staggered;
+    staggered.title("staggered sleeps").warmup(1).minEpochIterations(3);
+
+    for (auto slack : {std::chrono::microseconds(0), std::chrono::microseconds(1000),
+                       std::chrono::microseconds(5000)}) {
+        csp::runtime_options opts;
+        opts.num_procs = 1;
+        opts.timer_slack = slack;
+        csp::init_runtime(opts);
+
+        auto name = "slack " + std::to_string(slack.count()) + "us";
+        uint64_t runs = 0, before = csp::get_runtime_stats().timer_wakeups;
+        staggered.batch(SLEEPERS).run(name, [&] {
+            auto start = csp::clock::now();
+            for (int i = 0; i < SLEEPERS; ++i) {
+                csp::spawn([start, i] { csp::sleep_until(start + i * STAGGER); });
+            }
+            csp::schedule();
+            ++runs;
+        });
+        auto wakeups = csp::get_runtime_stats().timer_wakeups - before;
+        std::printf("%s: %.1f wakeups per %d sleeps\n", name.c_str(),
+                    double(wakeups) / double(runs), SLEEPERS);
+        csp::shutdown_runtime();
+    }
+}
@@ -3,8 +3,10 @@
 
 #include <csp/microthread.h>
 #include <csp/fcontext.h>
+#include <csp/internal/timer_wheel.h>
 
 #include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <cstddef>
 
@@ -29,28 +31,64 @@ namespace csp {
         enum class Status : intptr_t { run, sleep, detach, exit, spawn };
 
         struct Microthread;
+        struct Processor;
+        struct Runtime;
 
         extern thread_local Microthread * g_self;
 
         void do_switch(Status status = Status::sleep);
 
-        struct alignas(16) Microthread {
+        // Assumed size of a cache line, for separating fields written by
+        // different threads.  Apple's arm64 cores use 128-byte lines.
+#if defined(__APPLE__) && defined(__aarch64__)
+        constexpr size_t cache_line = 128;
+#else
+        constexpr size_t cache_line = 64;
+#endif
+
+        struct alignas(cache_line) Microthread {
             struct alignas(16) StackSlot { char c[16]; };
 
             static constexpr size_t stack_size = 32 << 10;
+            static constexpr int64_t no_deadline = INT64_MAX;
 
+            // Scheduling state, used on every switch.  Kept together at
+            // the start of the (line-aligned) struct.
             Microthread * prev_;
             Microthread * next_;
             std::atomic<fcontext_t> ctx_;
-            StackSlot * stk_;
-            char status_[32];
-            csp_chanop const * chanops_;
+            Runtime * rt_ = nullptr;  // Home runtime: the pool this MT runs in
+            Processor * last_p_ = nullptr;  // P that last switched to this MT
+            Processor * pin_ = nullptr;  // Dedicated P this MT is confined to
+            int64_t deadline_ns_ = no_deadline;  // EDF key (csp_set_deadline)
+            std::atomic<bool> wake_pending_{false};  // set by schedule() during suspending_ window
+            std::atomic<bool> suspending_{false};  // true from unlock_all to do_switch completion
+            bool in_global_ = false;  // true while in the global run queue
+            int64_t global_since_ns_ = 0;  // When pushed to the global queue
+
+            // Alt state, written by wakers.
+            enum AltState : uint32_t { ALT_IDLE, ALT_WAITING, ALT_CLAIMED };
+            std::atomic<uint32_t> alt_state{ALT_IDLE};
             int n_chanops_, signal_;
+            csp_chanop const * chanops_;
 
+            // Sleep or alt-timeout timer, and the processor whose wheel
+            // holds it.
+            TimerNode timer_;
+            Processor * timer_p_ = nullptr;
+            bool timer_armed_ = false;  // Armed for the do_switch under way (owner-only)
+
+            // Cold: set at spawn, read for cleanup and logging.
+            StackSlot * stk_;
             size_t id_ = []{
                 static std::atomic<size_t> next_{0};
                 return next_++;
             }();
+            char status_[32];
+
+#if CSP_TSAN
+            void* tsan_fiber_ = nullptr;  // TSan fiber handle for this microthread
+#endif
 
             Microthread(fcontext_t ctx, StackSlot * stk);
             Microthread();
@@ -64,20 +102,16 @@ namespace csp {
 
             void schedule(bool make_current = false);
             void schedule_local(bool make_current = false);
+            bool schedule_near(Processor & p);  // True iff queued on p
             void deschedule();
 
-            void run(Status status = Status::sleep);
-
-            enum AltState : uint32_t { ALT_IDLE, ALT_WAITING, ALT_CLAIMED };
-            std::atomic<uint32_t> alt_state{ALT_IDLE};
+            // Arm timer_ on the current processor.  A nonzero signal makes
+            // it an alt timeout: firing claims the alt and reports signal.
+            // Negative slack means the runtime's timer_slack.
+            void arm_timer(int64_t deadline_ns, int signal = 0, int64_t slack_ns = -1);
+            void cancel_timer();
 
-            bool in_global_ = false;  // true while in the global run queue
-            std::atomic<bool> wake_pending_{false};  // set by schedule() during suspending_ window
-            std::atomic<bool> suspending_{false};  // true from unlock_all to do_switch completion
-
-#if CSP_TSAN
-            void* tsan_fiber_ = nullptr;  // TSan fiber handle for this microthread
-#endif
+            void run(Status status = Status::sleep);
         };
 
         inline
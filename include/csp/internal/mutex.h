@@ -0,0 +1,52 @@
+#ifndef INCLUDED__csp__internal__mutex_h
+#define INCLUDED__csp__internal__mutex_h
+
+#include <mutex>
+
+// Build with -DCSP_SINGLE_THREADED=1 (make SINGLE_THREADED=1) to compile
+// out run-queue and channel locking altogether.  init_runtime then only
+// accepts one processor.
+#ifndef CSP_SINGLE_THREADED
+#define CSP_SINGLE_THREADED 0
+#endif
+
+namespace csp {
+
+    namespace detail {
+
+        // Cleared by init_runtime for runtime_options::single_threaded.
+        extern bool g_locking;
+
+        // A std::mutex that does nothing when only one OS thread can run
+        // microthreads.  Guards the run queues and channels, which are
+        // otherwise locked on every switch and every channel operation.
+        // The mode may only change while no Mutex is held.
+        class Mutex {
+        public:
+            static bool locking() {
+#if CSP_SINGLE_THREADED
+                return false;
+#else
+                return g_locking;
+#endif
+            }
+
+#if CSP_SINGLE_THREADED
+            void lock() { }
+            void unlock() { }
+            bool try_lock() { return true; }
+#else
+            void lock() { if (g_locking) mu_.lock(); }
+            void unlock() { if (g_locking) mu_.unlock(); }
+            bool try_lock() { return !g_locking || mu_.try_lock(); }
+
+        private:
+            std::mutex mu_;
+#endif
+        };
+
+    }
+
+}
+
+#endif // INCLUDED__csp__internal__mutex_h
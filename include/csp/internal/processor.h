@@ -2,50 +2,156 @@
 #define INCLUDED__csp__internal__processor_h
 
 #include <csp/internal/microthread_internal.h>
+#include <csp/internal/mutex.h>
 
 #include <chrono>
 #include <mutex>
-#include <queue>
-#include <vector>
 
 namespace csp {
 
     namespace detail {
 
-        struct TimerEntry {
-            std::chrono::steady_clock::time_point deadline;
-            Microthread * thread;
-            bool operator>(TimerEntry const & o) const { return deadline > o.deadline; }
-        };
+        // Time skipped by runtime_options::virtual_time.  Only grows.
+        extern std::atomic<int64_t> g_clock_offset_ns;
 
-        struct Processor {
-            Microthread  main;       // Sentinel node for this P's run queue
-            Microthread* busy;       // Head of circular DLL run queue
+        // The runtime's clock: steady_clock::now() plus any skipped time,
+        // in nanoseconds since steady_clock's epoch.
+        inline int64_t now_ns() {
+            using namespace std::chrono;
+            return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count()
+                + g_clock_offset_ns.load(std::memory_order_relaxed);
+        }
+
+        // The real steady_clock instant at which now_ns() reads ns, for
+        // waiting on OS primitives.
+        inline std::chrono::steady_clock::time_point real_time(int64_t ns) {
+            return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(
+                ns - g_clock_offset_ns.load(std::memory_order_relaxed)));
+        }
+
+        // Move now_ns() forward to target_ns, if it is behind.
+        void advance_clock(int64_t target_ns);
+
+        // Fields are grouped by who writes them: the owning worker alone,
+        // whoever holds timer_mu (the owner, idle processors firing its
+        // timers, microthreads cancelling theirs), or anyone holding
+        // run_mu (thieves, wakers).  The groups sit on separate cache
+        // lines so the others don't invalidate the owner's per-switch
+        // state.
+        struct alignas(cache_line) Processor {
+            // do_switch rereads round_ns at least this often.
+            static constexpr unsigned round_switches = 8;
+
+            // Owner-only; touched on every switch.
             std::atomic<fcontext_t>*  save_ctx;   // Where to store suspended mt's ctx
             Microthread*  save_mt;    // The microthread being suspended
+            Runtime* rt;             // Owning runtime (nullptr for limbo Ps)
+            int id;
+            bool dedicated = false;  // Runs only microthreads pinned to it
+            unsigned sched_tick = 0;          // Local dispatches since the last global poll
+            unsigned switches = 0;            // do_switch calls since round_ns was read
+            int64_t round_ns = 0;             // now_ns() at the start of this scheduling round
 
-            std::priority_queue<TimerEntry, std::vector<TimerEntry>,
-                                std::greater<TimerEntry>> timer_heap;
+            // Owner-only statistics.
+            std::atomic<uint64_t> deadline_dispatches{0};
+            std::atomic<uint64_t> deadline_misses{0};
+            std::atomic<uint64_t> colocated_wakeups{0};
+            std::atomic<uint64_t> timer_wakeups{0};
 
-            std::mutex run_mu;                // Protects the busy queue DLL
+            // Timers, under timer_mu: the owner arms and fires them, idle
+            // processors fire them while the owner is busy, and a
+            // microthread woken elsewhere cancels its own.
+            alignas(cache_line) Mutex timer_mu;
+            TimerWheel timers;
+            std::atomic<int64_t> next_timer_ns{INT64_MAX};  // Earliest timer (park predicate)
+            std::atomic<uint64_t> remote_timer_fires{0};
+            std::atomic<uint64_t> timer_lateness[runtime_stats::timer_lateness_buckets] = {};
+
+            // Shared run queue, written under run_mu by the owner, thieves
+            // and wakers.  main comes last: its links change along with
+            // its neighbours'.
+            alignas(cache_line) Mutex run_mu;   // Protects the busy queue DLL
+            Microthread* busy;       // Head of circular DLL run queue
             Microthread* running = nullptr;   // MT claimed by local_next (steal-safe)
+            std::atomic<int> queued{0};       // Linked MTs, excluding main (park predicate)
             std::atomic<bool> parked{false};  // Is this P's worker thread parked?
+            Microthread  main;       // Sentinel node for this P's run queue
 
-            int id;
-
-            Processor(int id_)
-                : busy(&main)
-                , save_ctx(nullptr)
+            Processor(int id_, Runtime* rt_ = nullptr)
+                : save_ctx(nullptr)
                 , save_mt(nullptr)
+                , rt(rt_)
                 , id(id_)
-            { }
+                , busy(&main)
+            {
+                main.rt_ = rt_;
+            }
 
             Processor(Processor const &) = delete;
             Processor& operator=(Processor const &) = delete;
+
+            // Link mt at the tail of the run queue.  Caller holds run_mu.
+            void link(Microthread* mt) {
+                if (busy) {
+                    mt->next_ = busy;
+                    mt->prev_ = busy->prev_;
+                    mt->next_->prev_ = mt->prev_->next_ = mt;
+                } else {
+                    busy = mt->next_ = mt->prev_ = mt;
+                }
+                if (mt != &main && Mutex::locking()) {
+                    queued.fetch_add(1, std::memory_order_release);
+                }
+            }
+
+            // Link mt right after pos, so it runs when pos yields.
+            // Caller holds run_mu; pos must be linked.
+            void link_after(Microthread* pos, Microthread* mt) {
+                mt->prev_ = pos;
+                mt->next_ = pos->next_;
+                mt->next_->prev_ = pos->next_ = mt;
+                if (Mutex::locking()) {
+                    queued.fetch_add(1, std::memory_order_release);
+                }
+            }
+
+            // Link a newly runnable mt where rt's run_queue_policy wants
+            // it.  Caller holds run_mu.
+            void push(Microthread* mt);
+
+            // Delink mt, moving busy past it.  Caller holds run_mu.
+            void unlink(Microthread* mt) {
+                if (busy == mt && (busy = mt->next_) == mt) {
+                    busy = nullptr;
+                }
+                mt->next_->prev_ = mt->prev_;
+                mt->prev_->next_ = mt->next_;
+                mt->next_ = nullptr;
+                mt->prev_ = nullptr;
+                if (mt != &main && Mutex::locking()) {
+                    queued.fetch_sub(1, std::memory_order_release);
+                }
+            }
+
+            // When the earliest timer may be due, without timer_mu.
+            int64_t next_timer() const {
+                return Mutex::locking() ? next_timer_ns.load(std::memory_order_acquire)
+                                        : timers.next_ns();
+            }
+
+            // Republish next_timer_ns after changing timers.  Caller holds
+            // timer_mu.
+            void timers_changed() {
+                if (!Mutex::locking()) {
+                    return;   // No parked workers to read it
+                }
+                next_timer_ns.store(timers.next_ns(), std::memory_order_release);
+            }
         };
 
         Processor& current_p();
         void bind_processor(Processor* p);
+        void unbind_processor();
 
     }
 
@@ -2,14 +2,18 @@
 #define INCLUDED__csp__internal__runtime_h
 
 #include <csp/internal/processor.h>
+#include <csp/scheduler.h>
 
 #include <atomic>
 #include <chrono>
+#include <climits>
 #include <condition_variable>
 #include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -17,22 +21,85 @@ namespace csp {
 
     namespace detail {
 
-        struct Runtime {
+        struct SharedTicker;
+
+        // Each group of fields written by different parties gets its own
+        // cache line; the read-mostly configuration checked on every
+        // switch shares the first.
+        struct alignas(cache_line) Runtime {
+            // Read-mostly: fixed by init() and shutdown().
             std::vector<std::unique_ptr<Processor>> procs;  // P0 = main thread
-            std::vector<std::thread> workers;               // M1..Mn
 
-            std::mutex global_mu;
+            runtime_options options;
+            std::shared_ptr<run_queue_policy> policy;   // Never null after init()
+
+            // Named pools have no main thread: every P gets a worker.
+            // threaded is set when microthreads may run on more than one
+            // OS thread, i.e. for pools and for the M:N default runtime.
+            std::string name;
+            bool is_pool = false;
+            bool threaded = false;
+
+            // procs[first_dedicated..] are reserved (options.dedicated_procs).
+            int first_dedicated = 0;
+
+            std::atomic<bool> stopping{false};
+
+            // Global run queue, written under global_mu by every worker:
+            // a FIFO, plus a heap of the entries the policy ranks
+            // (policy->ranks_global), ordered by policy->before() and then
+            // push order.
+            struct Ranked {
+                Microthread* mt;
+                uint64_t seq;
+            };
+            alignas(cache_line) std::mutex global_mu;
             std::deque<Microthread*> global_run_queue;
+            std::vector<Ranked> global_ranked;
+            uint64_t global_seq = 0;
+            std::atomic<int> global_len{0};   // Both sizes, readable without global_mu
+            int64_t max_global_wait_ns = 0;   // Under global_mu
 
-            std::mutex park_mu;
+            alignas(cache_line) std::mutex park_mu;
             std::condition_variable park_cv;
 
-            std::atomic<bool> stopping{false};
-            std::atomic<int> live_gs{0};
+            // One parked shared worker at a time watches every processor's
+            // timers, until timer_watch_ns, parked on timer_cv so that
+            // timer_armed wakes it alone.  INT64_MIN while none does.
+            std::condition_variable timer_cv;
+            bool timer_watcher = false;   // Under park_mu
+            bool main_waiting = false;    // In main_loop; under park_mu
+            std::atomic<int64_t> timer_watch_ns{INT64_MIN};
+
+            // Bumped by every spawn and exit, on any thread.
+            alignas(cache_line) std::atomic<int> live_gs{0};
+            std::atomic<unsigned> spread_next{0};   // placement::spread cursor
+            std::atomic<unsigned> dedicated_next{0};   // placement::dedicated cursor
+
+            // csp::shared_tick producers, by interval in nanoseconds.
+            std::mutex ticker_mu;
+            std::map<int64_t, std::shared_ptr<SharedTicker>> tickers;
+
+            // Processors released by csp_blocking, awaiting an OS thread.
+            // Guards workers too, since handoff() may start new threads.
+            alignas(cache_line) std::mutex spare_mu;
+            std::condition_variable spare_cv;
+            std::deque<Processor*> orphans;
+            int idle_spares = 0;
+            std::atomic<int> blocking_calls{0};   // In csp_blocking's f
+            std::vector<std::thread> workers;               // M1..Mn, plus spares
+            std::thread retired;                            // Last spare to quit, unjoined
 
             static Runtime& instance();
-            void init(int num_procs);   // 0 = hardware_concurrency
+            void init(runtime_options const & opts);
             void shutdown();
+
+            // Named pool registry.  Pools live until shutdown_runtime().
+            static Runtime* create_pool(std::string const & name,
+                                        runtime_options const & opts);
+            static Runtime* find_pool(std::string const & name);
+            static void shutdown_pools();
+
             void unpark_one();
 
             // Push a microthread to the global run queue.  Caller must
@@ -42,13 +109,58 @@ namespace csp {
             // this MT from the queue will see the null next_/prev_.
             void push_to_global(Microthread* mt);
 
+            // Queue a freshly spawned mt according to where (csp_place_*
+            // or a processor id), pinning it if that is a dedicated
+            // processor.  placeable() vets where beforehand.
+            bool placeable(int where) const;
+            void place(Microthread* mt, int where);
+
+            // Give p to a spare OS thread (starting one if none is idle)
+            // while the calling thread runs a blocking call.
+            void handoff(Processor& p);
+
+            // Idle spares beyond one per processor quit.
+            void worker_main(Processor* p);
             void worker_loop();
             void main_loop();
             Microthread* local_next(Processor& p);
-            bool take_from_global(Processor& p);
+            bool take_from_global(Processor& p, int max = INT_MAX);
+
+            // Count a local dispatch on p; every options.global_poll_interval
+            // dispatches, move one microthread from the global queue to p so
+            // a self-feeding local queue can't starve it.
+            void poll_global(Processor& p);
+            // Fire p's timers due by p.round_ns; skips timer_mu if none is.
             void fire_timers(Processor& p);
+
+            // Fire due timers of other, busy processors.  True iff any fired.
+            bool fire_remote_timers(Processor& thief);
+
+            // Expire p's timers due by now.  remote: p's owner is busy
+            // elsewhere, so wake through schedule().  Caller holds
+            // p.timer_mu.
+            void expire_timers(Processor& p, int64_t now, bool remote);
+
+            // A timer for deadline_ns was armed; wake the timer watcher
+            // if it would sleep past it.
+            void timer_armed(int64_t deadline_ns);
+            int64_t earliest_timer_ns() const;
+
+            // Virtual time: if self is the last worker awake, the main
+            // thread waits in main_loop and only timers remain, jump the
+            // clock to the next one and wake its owner.  Caller holds
+            // park_mu.
+            bool skip_to_next_timer(Processor& self);
             bool steal_work(Processor& thief);
             bool has_work(Processor& p);
+
+            // What to run next on p, from `from` (the round-robin choice)
+            // onwards: the policy's pick, or from.  Caller holds p.run_mu.
+            Microthread* pick(Processor& p, Microthread* from);
+
+            // Count the dispatch of mt toward the deadline counters and
+            // tell the policy.
+            void note_dispatch(Processor& p, Microthread* mt);
             std::optional<std::chrono::steady_clock::time_point>
                 next_timer_deadline(Processor& p);
         };
@@ -0,0 +1,305 @@
+#ifndef INCLUDED__csp__internal__timer_wheel_h
+#define INCLUDED__csp__internal__timer_wheel_h
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace csp {
+
+    namespace detail {
+
+        struct Microthread;
+
+        // A pending timer, embedded in whatever waits on it.  While
+        // pending it sits in exactly one wheel slot, the due list or the
+        // far-future heap, as recorded in `slot`.
+        struct TimerNode {
+            TimerNode * next = nullptr;
+            TimerNode * prev = nullptr;
+            int64_t tick = 0;                   // Fires once the wheel reaches it
+            int64_t deadline_ns = 0;            // As requested, before rounding or slack
+            Microthread * thread = nullptr;     // Who to wake
+            int slot = -1;                      // TimerWheel::unlinked, or where
+            int signal = 0;                     // Alt timeout: the chanop to report
+        };
+
+        // Hierarchical timing wheel: `levels` wheels of `slots` slots, each
+        // level's slot spanning a whole rotation of the level below.  A timer
+        // goes into the level of the highest bit in which its tick differs
+        // from the current tick, so insertion is O(1); expiry cascades each
+        // timer down at most once per level.  Timers beyond the top level
+        // (levels * slot_bits bits of ticks) wait in a heap until the wheel
+        // comes within range.  Deadlines round up to the next tick, so a
+        // timer fires up to one resolution late, never early.  A timer
+        // given slack may fire that much later again: its deadline rounds
+        // up to a multiple of the slack, so timers due within one window
+        // share a tick and expire in a single wakeup.
+        class TimerWheel {
+        public:
+            static constexpr int slot_bits = 6;
+            static constexpr int slots = 1 << slot_bits;
+            static constexpr int levels = 4;
+            static constexpr int64_t default_resolution_ns = 100'000;
+
+            // TimerNode::slot values besides level * slots + slot.
+            enum : int { unlinked = -1, in_due = -2, in_far = -3 };
+
+            explicit TimerWheel(int64_t resolution_ns = default_resolution_ns)
+                : res_(resolution_ns)
+            {
+            }
+
+            TimerWheel(TimerWheel const &) = delete;
+            TimerWheel & operator=(TimerWheel const &) = delete;
+
+            int64_t resolution_ns() const { return res_; }
+
+            // Only while empty.
+            void set_resolution_ns(int64_t ns) {
+                res_ = std::max<int64_t>(1, ns);
+                now_ = 0;
+            }
+
+            bool empty() const { return size_ == 0; }
+            size_t size() const { return size_; }
+
+            void add(TimerNode * n, int64_t deadline_ns, int64_t slack_ns = 0) {
+                n->deadline_ns = deadline_ns;
+                auto due = deadline_ns;
+                if (slack_ns > 0 && due > 0 && due < INT64_MAX - slack_ns) {
+                    due += slack_ns - 1 - (due - 1) % slack_ns;
+                }
+                n->tick = due / res_ + (due % res_ > 0);
+                ++size_;
+                insert(n);
+            }
+
+            // Cancel n in O(1) (O(far-heap size) for far-future timers).
+            // Return false if it wasn't pending.
+            bool remove(TimerNode * n) {
+                switch (n->slot) {
+                case unlinked:
+                    return false;
+                case in_due:
+                    unlink(due_, n);
+                    break;
+                case in_far:
+                    far_.erase(std::find(far_.begin(), far_.end(), n));
+                    std::make_heap(far_.begin(), far_.end(), later{});
+                    break;
+                default: {
+                    int level = n->slot / slots, s = n->slot % slots;
+                    unlink(wheel_[level][s], n);
+                    if (!wheel_[level][s]) {
+                        occupied_[level] &= ~(uint64_t(1) << s);
+                    }
+                }
+                }
+                n->next = n->prev = nullptr;
+                n->slot = unlinked;
+                --size_;
+                return true;
+            }
+
+            // Advance to now_ns, calling f(node) for every timer that is
+            // due, in tick order.  f must not touch the wheel.
+            template <typename F>
+            void expire(int64_t now_ns, F && f) {
+                auto target = now_ns / res_;
+                fire(due_, f);
+                while (now_ < target) {
+                    if (size_ == 0) {
+                        now_ = target;
+                        break;
+                    }
+                    now_ = std::min(next_tick(), target);
+
+                    // Cascade from the top down, so a timer can fall
+                    // through several levels at once.
+                    for (int level = levels - 1; level > 0; --level) {
+                        int shift = level * slot_bits;
+                        if ((now_ & ((int64_t(1) << shift) - 1)) == 0) {
+                            cascade(level, int(now_ >> shift) & (slots - 1));
+                        }
+                    }
+                    while (!far_.empty() && (far_.front()->tick >> range_bits) == (now_ >> range_bits)) {
+                        auto n = far_.front();
+                        std::pop_heap(far_.begin(), far_.end(), later{});
+                        far_.pop_back();
+                        insert(n);
+                    }
+                    fire(due_, f);
+                    auto head = take(0, int(now_) & (slots - 1));
+                    fire(head, f);
+                }
+            }
+
+            // The time the next timer may be due: exact for the lowest level,
+            // an earlier cascade point otherwise.  INT64_MAX if empty.
+            int64_t next_ns() const {
+                if (size_ == 0) {
+                    return INT64_MAX;
+                }
+                if (due_) {
+                    return now_ * res_;
+                }
+                auto t = next_tick();
+                return t == INT64_MAX ? INT64_MAX : t * res_;
+            }
+
+            // The time the next timer is due, exactly: what a thread that
+            // sleeps until then waits for.  Unlike next_ns(), it scans the
+            // first occupied slot of each level.  INT64_MAX if empty.
+            int64_t due_ns() const {
+                if (size_ == 0) {
+                    return INT64_MAX;
+                }
+                if (due_) {
+                    return now_ * res_;
+                }
+                int64_t best = INT64_MAX;
+                for (int level = 0; level < levels; ++level) {
+                    int c = int(now_ >> (level * slot_bits)) & (slots - 1);
+                    auto above = c == slots - 1 ? 0 : occupied_[level] & (~uint64_t(0) << (c + 1));
+                    if (above) {
+                        auto head = wheel_[level][__builtin_ctzll(above)];
+                        auto n = head;
+                        do {
+                            best = std::min(best, n->tick);
+                            n = n->next;
+                        } while (n != head);
+                    }
+                }
+                if (!far_.empty()) {
+                    best = std::min(best, far_.front()->tick);
+                }
+                return best * res_;
+            }
+
+        private:
+            static constexpr int range_bits = levels * slot_bits;
+
+            struct later {
+                bool operator()(TimerNode const * a, TimerNode const * b) const {
+                    return a->tick > b->tick;
+                }
+            };
+
+            // Circular DLLs, like the run queues: head->prev is the tail.
+            static void push(TimerNode *& head, TimerNode * n) {
+                if (head) {
+                    n->next = head;
+                    n->prev = head->prev;
+                    n->next->prev = n->prev->next = n;
+                } else {
+                    head = n->next = n->prev = n;
+                }
+            }
+
+            static void unlink(TimerNode *& head, TimerNode * n) {
+                if (n->next == n) {
+                    head = nullptr;
+                    return;
+                }
+                n->prev->next = n->next;
+                n->next->prev = n->prev;
+                if (head == n) {
+                    head = n->next;
+                }
+            }
+
+            void insert(TimerNode * n) {
+                auto t = n->tick;
+                if (t <= now_) {
+                    n->slot = in_due;
+                    push(due_, n);
+                    return;
+                }
+                int level = (63 - __builtin_clzll(uint64_t(t ^ now_))) / slot_bits;
+                if (level >= levels) {
+                    n->slot = in_far;
+                    far_.push_back(n);
+                    std::push_heap(far_.begin(), far_.end(), later{});
+                    return;
+                }
+                int s = int(t >> (level * slot_bits)) & (slots - 1);
+                n->slot = level * slots + s;
+                push(wheel_[level][s], n);
+                occupied_[level] |= uint64_t(1) << s;
+            }
+
+            TimerNode * take(int level, int s) {
+                auto head = wheel_[level][s];
+                wheel_[level][s] = nullptr;
+                occupied_[level] &= ~(uint64_t(1) << s);
+                return head;
+            }
+
+            void cascade(int level, int s) {
+                auto n = take(level, s);
+                if (!n) {
+                    return;
+                }
+                n->prev->next = nullptr;
+                while (n) {
+                    auto next = n->next;
+                    insert(n);
+                    n = next;
+                }
+            }
+
+            // Call f on every node of list, which is detached first.  Each
+            // node is unlinked before f sees it, so f may hand it to a
+            // thread that re-arms it.
+            template <typename F>
+            void fire(TimerNode *& list, F & f) {
+                auto n = list;
+                if (!n) {
+                    return;
+                }
+                list = nullptr;
+                n->prev->next = nullptr;
+                while (n) {
+                    auto next = n->next;
+                    n->next = n->prev = nullptr;
+                    n->slot = unlinked;
+                    --size_;
+                    f(n);
+                    n = next;
+                }
+            }
+
+            // The first tick after now_ at which a slot fires or cascades,
+            // or the far heap comes within range.
+            int64_t next_tick() const {
+                int64_t best = INT64_MAX;
+                for (int level = 0; level < levels; ++level) {
+                    int shift = level * slot_bits;
+                    int c = int(now_ >> shift) & (slots - 1);
+                    auto above = c == slots - 1 ? 0 : occupied_[level] & (~uint64_t(0) << (c + 1));
+                    if (above) {
+                        auto base = now_ >> (shift + slot_bits) << (shift + slot_bits);
+                        best = std::min(best, base | (int64_t(__builtin_ctzll(above)) << shift));
+                    }
+                }
+                if (!far_.empty()) {
+                    best = std::min(best, far_.front()->tick >> range_bits << range_bits);
+                }
+                return best;
+            }
+
+            int64_t res_;
+            int64_t now_ = 0;       // Every tick up to and including now_ has fired
+            size_t size_ = 0;
+            TimerNode * due_ = nullptr;
+            uint64_t occupied_[levels] = {};
+            TimerNode * wheel_[levels][slots] = {};
+            std::vector<TimerNode *> far_;     // Min-heap on tick
+        };
+
+    }
+
+}
+
+#endif // INCLUDED__csp__internal__timer_wheel_h
@@ -5,6 +5,7 @@
 
 #include <cassert>
 #include <exception>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -31,6 +32,41 @@ typedef void (*csp_entry_f)(void *);
  * Return non-zero iff the thread was created successfully. */
 int csp_spawn(csp_entry_f entry, void * data);
 
+/* A named scheduler pool: an independent runtime with its own processors,
+ * OS threads, run queues and timers. Channels work across pools; a
+ * microthread woken from another pool is queued back on its own. */
+typedef struct csp_tag_pool { char opaque; } * csp_pool;
+
+/* Create a pool with num_procs processors (0 = hardware concurrency). Only
+ * available once init_runtime has set up M:N mode. Return null if a pool
+ * with that name already exists or the runtime is single-threaded. */
+csp_pool csp_pool_create(char const * name, int num_procs);
+
+/* Return the pool with the given name, or null. */
+csp_pool csp_pool_find(char const * name);
+
+/* Like csp_spawn, but run the microthread in pool (null = the default
+ * runtime). */
+int csp_spawn_on(csp_pool pool, csp_entry_f entry, void * data);
+
+/* Where a new microthread is queued in M:N mode. Non-negative values name
+ * a processor; the main thread's processor (0) of the default runtime
+ * doesn't run microthreads and is rejected. A microthread placed on a
+ * dedicated processor (see runtime_options::dedicated_procs) stays there
+ * for life. Single-processor mode ignores placement and runs the
+ * microthread at once. */
+enum {
+    csp_place_default = -1,  /* The runtime's runtime_options::placement. */
+    csp_place_global  = -2,  /* Global run queue: the first idle worker. */
+    csp_place_local   = -3,  /* The spawner's processor, to run next. */
+    csp_place_spread  = -4,  /* Round-robin over the processors. */
+    csp_place_dedicated = -5,  /* Round-robin over the dedicated processors. */
+};
+
+/* Like csp_spawn_on, with explicit placement. Return 0 if placement names
+ * a processor that can't run microthreads. */
+int csp_spawn_placed(csp_pool pool, int placement, csp_entry_f entry, void * data);
+
 /* Run the currently scheduled microthread until it yields, then schedule
  * another microthread, but return without running it.
  * Return non-zero iff there remain threads that are ready to run. */
@@ -67,6 +103,25 @@ typedef struct csp_tag_reader { char can_wait; } * csp_reader;
  * Return non-zero iff success. */
 int csp_chan(csp_writer * w, csp_reader * r, void (* tx)(void * src, void * dst));
 
+/* How a buffered channel stores messages: size bytes apiece (at most
+ * max_align_t-aligned), moved into a slot from a writer's message with
+ * construct(src, slot), out of it into a reader's with take(slot, dst),
+ * and then destroyed. */
+typedef struct csp_tag_msgtype {
+    size_t size;
+    void (* construct)(void * src, void * slot);
+    void (* take)(void * slot, void * dst);
+    void (* destroy)(void * slot);
+} csp_msgtype;
+
+/* Like csp_chan, but the channel itself holds up to capacity messages:
+ * a write completes at once while there is room, and a read while any
+ * message is held, without waiting for the peer. Held messages are
+ * still delivered after the writer dies. capacity 0 makes an ordinary
+ * unbuffered channel. */
+int csp_chan_buffered(csp_writer * w, csp_reader * r, void (* tx)(void * src, void * dst),
+                      csp_msgtype const * type, size_t capacity);
+
 /* Add and release refcount on writers and readers. */
 csp_writer csp_writer_addref (csp_writer w);
 void        csp_writer_release(csp_writer w);
@@ -83,6 +138,11 @@ enum { csp_dead = 2, csp_ready = csp_dead | 1 };
 #define csp_wait(obj) ((csp_waiter)((uintptr_t)&(obj)->can_wait | ((int)::csp_ready << 1) | 8))
 #define csp_wait_dead(obj) ((csp_waiter)((uintptr_t)&(obj)->can_wait | ((int)::csp_dead << 1) | 8))
 
+/* A timeout operand for csp_(pri)alt, signalled once steady_clock
+ * passes the deadline (in nanoseconds) held in the chanop's message as
+ * an intptr_t. It costs one timer, not a microthread. */
+#define csp_wait_timeout ((csp_waiter)(uintptr_t)8)
+
 typedef struct csp_tag_chanop {
     csp_waiter waiter;
     void * message;
@@ -92,7 +152,8 @@ typedef struct csp_tag_chanop {
  * signalled end-point.
  *
  * A signalled writer returns after the reader has processed the
- * message, and may thus safely send stack object addresses.
+ * message, and may thus safely send stack object addresses (unless the
+ * channel is buffered).
  *
  * If several waitops are ready at the same time, alt chooses randomly
  * and is thus fairer, whereas prialt chooses the lowest index and is
@@ -100,10 +161,64 @@ typedef struct csp_tag_chanop {
 int csp_alt   (csp_chanop const * waitops, int count, int nowait);
 int csp_prialt(csp_chanop const * waitops, int count, int nowait);
 
+/* A select set: an alt whose chanops stay registered on their channels
+ * between waits, so a wait costs only the channels that have seen a
+ * peer since. It belongs to the microthread that creates it, which alone
+ * may add to, remove from, wait on and free it.
+ *
+ * csp_select_add returns the chanop's id (> 0), or 0 for a chanop with
+ * no channel. Its message must stay put until it is removed. The set
+ * holds a reference to the chanop's endpoint until then, so the caller
+ * may release its own.
+ *
+ * csp_select_wait completes one ready chanop and returns its id, -id if
+ * its channel is dead, or 0 if nowait and none is ready. A write that
+ * sends its message leaves the set, freeing its id; add it again to send
+ * another. Reads stay in the set and fire again on the next message, and
+ * a dead channel keeps reporting -id until removed. */
+typedef struct csp_tag_select * csp_select;
+csp_select csp_select_new(void);
+void csp_select_free(csp_select s);
+int  csp_select_add(csp_select s, csp_chanop chop);
+void csp_select_remove(csp_select s, int id);
+int  csp_select_wait(csp_select s, int nowait);
+
 /* Block the current microthread until the given deadline (nanoseconds since
  * steady_clock epoch). */
 void csp_sleep_until(int64_t deadline_ns);
 
+/* csp_sleep_until, waking up to slack_ns late (negative: the runtime's
+ * timer_slack). Sleeps whose deadlines fall in the same slack-aligned
+ * window wake together, costing one processor wakeup between them. */
+void csp_sleep_until_slack(int64_t deadline_ns, int64_t slack_ns);
+
+/* Attach a scheduling deadline (nanoseconds since steady_clock epoch) to the
+ * current microthread. Under the EDF policy, runnable microthreads with the
+ * earliest deadline run first. Pass INT64_MAX to clear the deadline. */
+void csp_set_deadline(int64_t deadline_ns);
+
+/* The runtime's clock: steady_clock nanoseconds since its epoch, plus any
+ * idle time skipped under runtime_options::virtual_time. Timers and
+ * csp::clock::now() use it. */
+int64_t csp_now(void);
+
+/* steady_clock nanoseconds as of the start of the current processor's
+ * scheduling round. A round starts when the processor looks for work, and
+ * at least every eighth switch between microthreads (every switch while
+ * timers are armed). Costs no clock read, but lags by up to eight
+ * dispatches, the caller's own run so far included. Precise outside
+ * microthreads. */
+int64_t csp_coarse_now(void);
+
+/* Call f(data), which may block the OS thread (disk I/O, legacy clients).
+ * In M:N mode the current processor and its run queue are handed to a
+ * spare OS thread for the duration, and the microthread rejoins the global
+ * run queue afterwards. f runs outside the scheduler, so it must not call
+ * into csp: no channel operations, alts or selects, sleeps, yields, spawns
+ * or nested csp_blocking calls. Afterwards the OS thread waits as a spare
+ * for later calls, unless one per processor already does. */
+void csp_blocking(void (* f)(void *), void * data);
+
 /* Don't call these. */
 int csp__internal__init(void* stack, int stacksize);
 char const * csp__internal__getchdescr(void* ch);
@@ -114,8 +229,14 @@ char const * csp__internal__getchflags(void* ch);
 }
 
 #include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
+#include <memory>
+#include <new>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -146,10 +267,89 @@ namespace csp
     void set_scheduler(std::function<void()> f);
     void schedule();
 
+    // Order in which each processor runs its runnable microthreads.
+    enum class sched_policy {
+        fifo,   // Round-robin in queue order.
+        edf,    // Earliest deadline first (see csp_set_deadline); microthreads
+                // without a deadline run round-robin after those with one.
+        lifo,   // A microthread that becomes runnable runs next.
+    };
+
+    class run_queue_policy;     // See csp/scheduler.h.
+
+    // Where spawn queues a new microthread (see csp_spawn_placed).
+    enum class placement : int {
+        global = csp_place_global,  // First idle worker.
+        local = csp_place_local,    // Spawner's processor; runs when it yields.
+        spread = csp_place_spread,  // Round-robin over the shared processors.
+        dedicated = csp_place_dedicated,  // Round-robin over the dedicated
+                                          // processors, for life.
+    };
+
+    // Start a new microthread on processor id; for life if id is dedicated.
+    inline placement on_processor(int id) {
+        return placement(id);
+    }
+
+    struct runtime_options {
+        int num_procs = 0;                      // 0 = hardware_concurrency
+        sched_policy policy = sched_policy::fifo;
+        std::shared_ptr<run_queue_policy> queue_policy;  // Overrides policy.
+        int global_poll_interval = 61;          // Check the global queue every
+                                                // N local dispatches (0 = never).
+        bool single_threaded = false;           // One processor, no run-queue or
+                                                // channel locking. Microthreads and
+                                                // channels must then stay on the
+                                                // calling OS thread.
+        placement spawn_placement = placement::global;  // Default for spawn
+                                                        // (see bench/spawn.bench.cc).
+        std::chrono::nanoseconds timer_resolution{100'000};  // Timer wheel tick:
+                                                // sleeps wake up to this late.
+        int dedicated_procs = 0;                // Reserve the last N processors for
+                                                // microthreads placed there. They
+                                                // never steal or take from the
+                                                // global queue, nor are stolen from.
+        bool virtual_time = false;              // When all workers are idle with
+                                                // only timers pending, jump the
+                                                // clock (csp_now) to the next one.
+                                                // Default runtime only.
+        std::chrono::nanoseconds timer_slack{0};  // Let sleeps and timeouts
+                                                // wake up to this late, batching
+                                                // deadlines in the same window
+                                                // into one wakeup. 0 = exact.
+    };
+
     // Initialize the M:N runtime with the given number of processors (0 = auto).
     // If never called, auto-initializes with 1 processor (single-threaded).
     void init_runtime(int num_procs = 0);
-    void shutdown_runtime();
+    void init_runtime(runtime_options const & options);
+    void shutdown_runtime();   // Also shuts down every pool.
+
+    // Named scheduler pools (see csp_pool_create). Keep I/O-facing
+    // microthreads away from CPU-heavy ones by spawning each kind on its
+    // own pool. Throws microthread_error if the pool can't be created.
+    using pool = csp_pool;
+    pool create_pool(std::string const & name, int num_procs = 0);
+    pool create_pool(std::string const & name, runtime_options const & options);
+    pool find_pool(std::string const & name);   // nullptr if none
+
+    // Scheduler counters, summed over all processors since init_runtime.
+    struct runtime_stats {
+        static constexpr int timer_lateness_buckets = 16;
+
+        uint64_t deadline_dispatches = 0;   // Runs of microthreads with a deadline.
+        uint64_t deadline_misses = 0;       // ...whose deadline had already passed.
+        uint64_t colocated_wakeups = 0;     // Channel peers woken onto the waker's processor.
+        uint64_t max_global_wait_ns = 0;    // Longest stay in a global run queue.
+        uint64_t remote_timer_fires = 0;    // Timers fired by an idle processor for a busy one.
+        uint64_t timer_wakeups = 0;         // Idle waits ended by a timer deadline.
+
+        // Timers fired, by how late: bucket 0 under 1µs, bucket i from
+        // 2^(i-1)µs up to 2^iµs, the last bucket everything beyond.
+        uint64_t timer_lateness[timer_lateness_buckets] = {};
+    };
+
+    runtime_stats get_runtime_stats();
 
     class microthread_error : public std::runtime_error {
     public:
@@ -165,18 +365,31 @@ namespace csp
         explicit operator bool() const { return false; }
     } poke;
 
+    class select_set;
+
     class action {
     public:
         using cleanup_f = void (*)(void *);
+        using relocate_f = void (*)(void * src, void * dst);
+
+        // Sent messages up to this size (pointer-aligned and nothrow
+        // movable) live in the action itself, and move with it.
+        static constexpr size_t inline_size = 4 * sizeof(void *);
+
+        template <typename T>
+        static constexpr bool holds_inline() {
+            return sizeof(T) <= inline_size && alignof(T) <= alignof(void *)
+                && std::is_nothrow_move_constructible<T>::value;
+        }
 
         action() = default;
         action(action && a)
             : chanop_(a.chanop_)
             , cleanup_(a.cleanup_)
+            , relocate_(a.relocate_)
             , active_{a.active_ = false}
         {
-            a.chanop_ = {nullptr, nullptr};
-            a.cleanup_ = nullptr;
+            take_message(a);
         }
         action(action const &) = delete;
 
@@ -186,6 +399,17 @@ namespace csp
         {
         }
 
+        // Wait on waiter with a T made from u as the message, held inline.
+        template <typename T, typename U>
+        action(csp_waiter waiter, std::in_place_type_t<T>, U && u)
+            : chanop_{waiter, storage_}
+            , cleanup_(std::is_trivially_destructible<T>::value ? nullptr : &destroy<T>)
+            , relocate_(&relocate<T>)
+        {
+            static_assert(holds_inline<T>(), "message too big to hold inline");
+            new (storage_) T(std::forward<U>(u));
+        }
+
         ~action() {
             if (active_) {
                 csp_prialt(&chanop_, 1, false);
@@ -196,11 +420,16 @@ namespace csp
         }
 
         action & operator=(action && a) {
-            chanop_ = a.chanop_;
-            cleanup_ = a.cleanup_;
-            active_ = a.active_ = false;
-            a.chanop_ = {nullptr, nullptr};
-            a.cleanup_ = nullptr;
+            if (this != &a) {
+                if (cleanup_) {
+                    cleanup_(chanop_.message);
+                }
+                chanop_ = a.chanop_;
+                cleanup_ = a.cleanup_;
+                relocate_ = a.relocate_;
+                active_ = a.active_ = false;
+                take_message(a);
+            }
             return *this;
         }
         action & operator=(action const &) = delete;
@@ -210,13 +439,46 @@ namespace csp
             return csp_prialt(&chanop_, 1, false) > 0;
         }
 
+        // Perform the action only if a peer is ready now.  Return > 0 if
+        // done, 0 if not ready, < 0 if the other end is gone.
+        int try_run() const {
+            active_ = false;
+            return csp_prialt(&chanop_, 1, true);
+        }
+
         csp_chanop chanop() const { return chanop_; }
 
         bool empty() const { return !chanop_.waiter; }
 
     private:
+        template <typename T>
+        static void destroy(void * p) {
+            static_cast<T *>(p)->~T();
+        }
+
+        template <typename T>
+        static void relocate(void * src, void * dst) {
+            new (dst) T(std::move(*static_cast<T *>(src)));
+            static_cast<T *>(src)->~T();
+        }
+
+        // Having copied a's fields, bring its inline message along.
+        void take_message(action & a) {
+            if (relocate_) {
+                relocate_(a.storage_, storage_);
+                chanop_.message = storage_;
+            }
+            a.chanop_ = {nullptr, nullptr};
+            a.cleanup_ = nullptr;
+            a.relocate_ = nullptr;
+        }
+
+        friend class select_set;
+
         csp_chanop chanop_ = {nullptr, nullptr};
-        cleanup_f cleanup_;
+        cleanup_f cleanup_ = nullptr;
+        relocate_f relocate_ = nullptr;     // Set iff the message is in storage_
+        alignas(void *) unsigned char storage_[inline_size];
         mutable bool active_ = true;
     };
 
@@ -245,26 +507,28 @@ namespace csp
 
     template <typename T> class channel;
 
+    // Messages that travel in the chanop's message pointer itself.
     template <typename T>
     struct is_tunnelable_via_ptr {
-        static const bool value = false; //std::is_pod<T>::value && sizeof(T) <= sizeof(void *);
+        static const bool value = std::is_trivially_copyable<T>::value
+            && sizeof(T) <= sizeof(void *) && alignof(T) <= alignof(void *);
     };
 
     namespace detail {
 
-        template <typename T>
-        action writer_action(csp_writer w, T const & t, std::enable_if_t<is_tunnelable_via_ptr<T>::value> * = nullptr) {
-            union {
-                void * p;
-                T t;
-            } u;
-            u.t = t;
-            return {csp_chanop{csp_wait(w), u.p}, nullptr};
-        }
-
-        template <typename T>
-        action writer_action(csp_writer w, T const & t, std::enable_if_t<!is_tunnelable_via_ptr<T>::value> * = nullptr) {
-            return {csp_chanop{csp_wait(w), new T(t)}, [](void * p) { delete (T *)(p); }};
+        // Send u as a T without touching the heap unless T is too big to
+        // hold inline.
+        template <typename T, typename U>
+        action writer_action(csp_writer w, U && u) {
+            if constexpr (is_tunnelable_via_ptr<T>::value) {
+                void * p = nullptr;
+                std::memcpy(&p, std::addressof(u), sizeof(T));
+                return {csp_chanop{csp_wait(w), p}, nullptr};
+            } else if constexpr (action::holds_inline<T>()) {
+                return action(csp_wait(w), std::in_place_type<T>, std::forward<U>(u));
+            } else {
+                return {csp_chanop{csp_wait(w), new T(std::forward<U>(u))}, [](void * p) { delete (T *)(p); }};
+            }
         }
 
         template <typename T>
@@ -275,12 +539,7 @@ namespace csp
 
         template <typename T>
         void tx_message_(void * src, void * dst, std::enable_if_t<is_tunnelable_via_ptr<T>::value> * = nullptr) {
-            union {
-                void * p;
-                T t;
-            } u;
-            u.p = src;
-            *static_cast<T *>(dst) = std::move(u.t);
+            std::memcpy(dst, &src, sizeof(T));
         }
 
         template <typename T>
@@ -288,6 +547,38 @@ namespace csp
             tx_message_<T>(src, dst);
         }
 
+        template <typename T>
+        void construct_message_(void * src, void * slot, std::enable_if_t<!is_tunnelable_via_ptr<T>::value> * = nullptr) {
+            new (slot) T(std::move(*static_cast<T *>(src)));
+        }
+
+        template <typename T>
+        void construct_message_(void * src, void * slot, std::enable_if_t<is_tunnelable_via_ptr<T>::value> * = nullptr) {
+            std::memcpy(slot, &src, sizeof(T));
+        }
+
+        template <typename T>
+        void construct_message(void * src, void * slot) {
+            construct_message_<T>(src, slot);
+        }
+
+        template <typename T>
+        void take_message(void * slot, void * dst) {
+            *static_cast<T *>(dst) = std::move(*static_cast<T *>(slot));
+        }
+
+        template <typename T>
+        void destroy_message(void * slot) {
+            static_cast<T *>(slot)->~T();
+        }
+
+        template <typename T>
+        csp_msgtype const * message_type() {
+            static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned channel message");
+            static csp_msgtype const type = {sizeof(T), &construct_message<T>, &take_message<T>, &destroy_message<T>};
+            return &type;
+        }
+
     }
 
     template <typename T = poke_t>
@@ -329,10 +620,8 @@ namespace csp
 
         void descr(const char* d) const { csp_chdescr(w_, d); }
 
-        action operator<<(T const & t) const { return detail::writer_action(w_, t); }
-        action operator<<(T && t) const {
-            return {csp_chanop{csp_wait(w_), new T(std::move(t))}, [](void * p) { delete (T *)(p); }};
-        }
+        action operator<<(T const & t) const { return detail::writer_action<T>(w_, t); }
+        action operator<<(T && t) const { return detail::writer_action<T>(w_, std::move(t)); }
 
         action operator~() const {
             return {csp_chanop{csp_wait_dead(w_), nullptr}, nullptr};
@@ -480,6 +769,17 @@ namespace csp
             w_.assign(w);
             r_.assign(r);
         }
+        // A buffered channel, holding up to capacity messages in flight
+        // (see csp_chan_buffered); 0 is the same as channel().
+        explicit channel(size_t capacity) {
+            csp_writer w;
+            csp_reader r;
+            if (csp_chan_buffered(&w, &r, &detail::tx_message<T>, detail::message_type<T>(), capacity) == 0) {
+                throw microthread_error("channel creation failed");
+            }
+            w_.assign(w);
+            r_.assign(r);
+        }
         channel(writer<T> w, reader<T> r) : w_(w), r_(r) { }
         channel(channel const &) = default;
         channel(channel && e) : w_(std::move(e.w_)), r_(std::move(e.r_)) {
@@ -632,14 +932,75 @@ namespace csp
 
     }
 
+    namespace detail {
+
+        template <typename F>
+        reader<std::exception_ptr> spawn_placed(pool p, int where, F && f) {
+            reader<std::exception_ptr> r;
+            auto sd = new spawn_data<F>{std::move(f), ++r};
+            if (!csp_spawn_placed(p, where, spawn_entry<F>, sd)) {
+                delete sd;
+                throw microthread_error("spawn failed");
+            }
+            return r;
+        }
+
+    }
+
+    template <typename F>
+    reader<std::exception_ptr> spawn_on(pool p, placement where, F && f) {
+        return detail::spawn_placed(p, int(where), std::forward<F>(f));
+    }
+
+    template <typename F>
+    reader<std::exception_ptr> spawn_on(pool p, F && f) {
+        return detail::spawn_placed(p, csp_place_default, std::forward<F>(f));
+    }
+
+    template <typename F>
+    reader<std::exception_ptr> spawn(placement where, F && f) {
+        return detail::spawn_placed(nullptr, int(where), std::forward<F>(f));
+    }
+
     template <typename F>
     reader<std::exception_ptr> spawn(F && f) {
-        reader<std::exception_ptr> r;
-        auto sd = new detail::spawn_data<F>{std::move(f), ++r};
-        if (!csp_spawn(detail::spawn_entry<F>, sd)) {
-            throw microthread_error("spawn failed");
+        return detail::spawn_placed(nullptr, csp_place_default, std::forward<F>(f));
+    }
+
+    namespace detail {
+
+        template <typename F>
+        inline void invoke_entry(void * data) {
+            (*static_cast<F *>(data))();
+        }
+
+    }
+
+    // Run f on the current OS thread without stalling other microthreads
+    // (see csp_blocking). Returns f's result or rethrows its exception.
+    template <typename F>
+    auto blocking(F && f) {
+        using R = std::decay_t<std::invoke_result_t<F &>>;
+        std::exception_ptr ex;
+        if constexpr (std::is_void<R>::value) {
+            auto call = [&]{
+                try { f(); } catch (...) { ex = std::current_exception(); }
+            };
+            csp_blocking(detail::invoke_entry<decltype(call)>, &call);
+            if (ex) {
+                std::rethrow_exception(ex);
+            }
+        } else {
+            std::optional<R> result;
+            auto call = [&]{
+                try { result.emplace(f()); } catch (...) { ex = std::current_exception(); }
+            };
+            csp_blocking(detail::invoke_entry<decltype(call)>, &call);
+            if (ex) {
+                std::rethrow_exception(ex);
+            }
+            return std::move(*result);
         }
-        return r;
     }
 
     inline void join(reader<std::exception_ptr> r) {
@@ -735,9 +1096,29 @@ namespace csp
 
         using csp_alt_f = int(csp_chanop const * waiter, int count, int nowait);
 
+        // Alts of up to this many actions copy their chanops to the stack.
+        constexpr size_t small_alt = 8;
+
+        template <detail::csp_alt_f baf, size_t N>
+        inline
+        int alt(action const * io) {
+            std::array<csp_chanop, N> chanops;
+            for (size_t i = 0; i < N; ++i) {
+                chanops[i] = io[i].chanop();
+            }
+            return baf(chanops.data(), int(N), 0);
+        }
+
         template <detail::csp_alt_f baf>
         inline
         int alt(action const * io, size_t n) {
+            if (n <= small_alt) {
+                std::array<csp_chanop, small_alt> chanops;
+                for (size_t i = 0; i < n; ++i) {
+                    chanops[i] = io[i].chanop();
+                }
+                return baf(chanops.data(), int(n), 0);
+            }
             std::vector<csp_chanop> chanops;
             chanops.reserve(n);
             for (size_t i = 0; i < n; ++i) {
@@ -756,7 +1137,7 @@ namespace csp
     template <int N>
     inline
     int alt(action const (& io)[N]) {
-        return alt(io, N);
+        return detail::alt<csp_alt, N>(io);
     }
 
     inline
@@ -770,7 +1151,7 @@ namespace csp
         constexpr size_t n = 1 + sizeof...(aa);
         action actions[n] = {std::move(a)};
         detail::insert_actions(actions + 1, std::forward<Actions>(aa)...);
-        return alt(actions, n);
+        return detail::alt<csp_alt, n>(actions);
     }
 
     inline
@@ -781,7 +1162,7 @@ namespace csp
     template <int N>
     inline
     int prialt(action const (& io)[N]) {
-        return prialt(io, N);
+        return detail::alt<csp_prialt, N>(io);
     }
 
     inline
@@ -795,9 +1176,61 @@ namespace csp
         constexpr size_t n = 1 + sizeof...(aa);
         action actions[n] = {std::move(a)};
         detail::insert_actions(actions + 1, std::forward<Actions>(aa)...);
-        return prialt(actions, n);
+        return detail::alt<csp_prialt, n>(actions);
     }
 
+    // An alt whose actions stay registered between waits (csp_select),
+    // for microthreads that wait on many channels in a loop.  wait()
+    // returns the id that add() gave the action it completed, or -id if
+    // its channel is dead.  A read stays in the set until removed, firing
+    // on each message; a write leaves it once it has sent its message.
+    // Only the microthread that made the set may use it.
+    class select_set {
+    public:
+        select_set() : s_(csp_select_new()) { }
+        ~select_set() { csp_select_free(s_); }
+
+        select_set(select_set const &) = delete;
+        select_set & operator=(select_set const &) = delete;
+
+        int add(action a) {
+            auto p = std::make_unique<action>(std::move(a));
+            p->active_ = false;
+            int id = csp_select_add(s_, p->chanop_);
+            if (id > 0) {
+                if (size_t(id) > actions_.size()) {
+                    actions_.resize(id);
+                }
+                actions_[id - 1] = std::move(p);
+            }
+            return id;
+        }
+
+        void remove(int id) {
+            csp_select_remove(s_, id);
+            if (id > 0 && size_t(id) <= actions_.size()) {
+                actions_[id - 1].reset();
+            }
+        }
+
+        int wait() { return done(csp_select_wait(s_, 0)); }
+
+        // 0 if no action is ready.
+        int try_wait() { return done(csp_select_wait(s_, 1)); }
+
+    private:
+        // A write that sent has left the set: drop its action.
+        int done(int id) {
+            if (id > 0 && !(uintptr_t(actions_[id - 1]->chanop_.waiter) & 1)) {
+                actions_[id - 1].reset();
+            }
+            return id;
+        }
+
+        csp_select s_;
+        std::vector<std::unique_ptr<action>> actions_;  // By id - 1
+    };
+
     // Dead channel to assist non-blocking waits.
     extern reader<> const skip;
 
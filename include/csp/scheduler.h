@@ -0,0 +1,164 @@
+#ifndef INCLUDED__csp__scheduler_h
+#define INCLUDED__csp__scheduler_h
+
+#include <csp/microthread.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace csp {
+
+    namespace detail {
+        struct Microthread;
+    }
+
+    // A runnable microthread, as seen by a run_queue_policy. Only valid
+    // for the duration of the hook that receives it.
+    class task {
+    public:
+        task() = default;
+        explicit task(detail::Microthread * mt) : mt_(mt) { }
+
+        explicit operator bool() const { return mt_ != nullptr; }
+        bool operator==(task const & that) const { return mt_ == that.mt_; }
+        bool operator!=(task const & that) const { return mt_ != that.mt_; }
+
+        size_t id() const;
+        int64_t deadline_ns() const;    // INT64_MAX if none (csp_set_deadline)
+
+        detail::Microthread * get() const { return mt_; }
+
+    private:
+        detail::Microthread * mt_ = nullptr;
+    };
+
+    // A processor's run queue as seen by a run_queue_policy: the runnable
+    // microthreads in round-robin order, starting with the one due next,
+    // minus the one that is running. Never empty when handed to a hook.
+    class run_queue {
+    public:
+        class iterator {
+        public:
+            iterator(run_queue const * q, detail::Microthread * mt) : q_(q), mt_(mt) { }
+            task operator*() const { return task(mt_); }
+            iterator & operator++();
+            bool operator==(iterator const & that) const { return mt_ == that.mt_; }
+            bool operator!=(iterator const & that) const { return mt_ != that.mt_; }
+
+        private:
+            run_queue const * q_;
+            detail::Microthread * mt_;
+        };
+
+        // The entries from `first` round to just before it, skipping the
+        // sentinel and the `skip` microthreads.
+        run_queue(detail::Microthread * first, detail::Microthread * sentinel,
+                  detail::Microthread * skip, detail::Microthread * skip2 = nullptr)
+            : first_(first), sentinel_(sentinel), skip_(skip), skip2_(skip2) { }
+
+        iterator begin() const;
+        iterator end() const { return iterator(this, nullptr); }
+        bool empty() const { return begin() == end(); }
+        task front() const { return *begin(); }
+        task back() const;
+
+    private:
+        friend class iterator;
+        bool skipped(detail::Microthread * mt) const {
+            return mt == sentinel_ || mt == skip_ || mt == skip2_;
+        }
+
+        detail::Microthread * first_;
+        detail::Microthread * sentinel_;
+        detail::Microthread * skip_;
+        detail::Microthread * skip2_;
+    };
+
+    enum class run_queue_event {
+        push,       // A microthread became runnable on this processor.
+        dispatch,   // A microthread was picked to run.
+        steal,      // A microthread was taken by another processor.
+    };
+
+    // Queueing decisions for every processor of a runtime, chosen with
+    // runtime_options::queue_policy. The run queues themselves stay
+    // intrusive lists owned by the runtime; a policy only picks positions
+    // and entries. Hooks run under a processor's run-queue lock (or the
+    // global queue's lock), concurrently for different processors, so
+    // they must be thread-safe and must not block or switch.
+    class run_queue_policy {
+    public:
+        virtual ~run_queue_policy() = default;
+
+        virtual char const * name() const = 0;
+
+        // t became runnable. Return true for it to run next on its
+        // processor (right after the queue's head, which may be running)
+        // rather than after the microthreads already queued.
+        virtual bool push(task t) { (void)t; return false; }
+
+        // Choose what to run next from q, or return a null task to keep
+        // round-robin order.
+        virtual task pop(run_queue const & q) { (void)q; return task(); }
+
+        // Choose what another processor takes from q, or return a null
+        // task to refuse.
+        virtual task steal(run_queue const & q) { return q.back(); }
+
+        // How many of the `available` global run queue entries one of
+        // `procs` processors takes at a time.
+        virtual int take(int available, int procs) {
+            return std::max(1, available / procs);
+        }
+
+        // Whether t, entering the global run queue, waits in a heap ordered
+        // by before() rather than in FIFO order. A take hands out the
+        // heap's top unless before() ranks the FIFO's head ahead of it.
+        virtual bool ranks_global(task t) const { (void)t; return false; }
+        virtual bool before(task a, task b) const { (void)a; (void)b; return false; }
+
+        virtual void notify(run_queue_event e, task t) { (void)e; (void)t; }
+    };
+
+    // sched_policy::fifo: the default round-robin behaviour.
+    class fifo_policy : public run_queue_policy {
+    public:
+        char const * name() const override { return "fifo"; }
+    };
+
+    // sched_policy::lifo: a newly runnable microthread runs next, which
+    // keeps a just-woken peer's data hot in cache.
+    class lifo_policy : public run_queue_policy {
+    public:
+        char const * name() const override { return "lifo"; }
+        bool push(task) override { return true; }
+    };
+
+    // sched_policy::edf: earliest deadline first; microthreads without a
+    // deadline run round-robin after those with one.
+    class edf_policy : public run_queue_policy {
+    public:
+        char const * name() const override { return "edf"; }
+        task pop(run_queue const & q) override { return most_urgent(q); }
+        task steal(run_queue const & q) override {
+            auto t = most_urgent(q);
+            return t ? t : q.back();
+        }
+        bool ranks_global(task t) const override { return t.deadline_ns() != INT64_MAX; }
+        bool before(task a, task b) const override {
+            return a.deadline_ns() < b.deadline_ns();
+        }
+
+        // The entry with the earliest deadline (ties go to queue order),
+        // or a null task if none has one.
+        static task most_urgent(run_queue const & q);
+    };
+
+    // The built-in policy for p.
+    std::shared_ptr<run_queue_policy> make_queue_policy(sched_policy p);
+
+}
+
+#endif // INCLUDED__csp__scheduler_h
@@ -7,7 +7,20 @@
 
 namespace csp {
 
-    using clock = std::chrono::steady_clock;
+    // steady_clock, but reading csp_now(), so that it follows virtual
+    // time (runtime_options::virtual_time).
+    struct clock : std::chrono::steady_clock {
+        static time_point now() noexcept {
+            return time_point(duration(csp_now()));
+        }
+
+        // now() as of this processor's current scheduling round (see
+        // csp_coarse_now): free to read, but up to eight dispatches
+        // stale, the caller's own run so far included.
+        static time_point coarse_now() {
+            return time_point(duration(csp_coarse_now()));
+        }
+    };
 
     // Block the current microthread until the given deadline.
     inline void sleep_until(clock::time_point tp) {
@@ -19,27 +32,69 @@ namespace csp {
         sleep_until(clock::now() + d);
     }
 
-    // Return a reader that fires once after the given duration.
+    // As above, but allowed to wake up to slack late, sharing a wakeup
+    // with other timers due in the same window (csp_sleep_until_slack).
+    inline void sleep_until(clock::time_point tp, clock::duration slack) {
+        csp_sleep_until_slack(tp.time_since_epoch().count(), slack.count());
+    }
+
+    inline void sleep(clock::duration d, clock::duration slack) {
+        sleep_until(clock::now() + d, slack);
+    }
+
+    // Give the current microthread a scheduling deadline, used by the
+    // sched_policy::edf run-queue policy.
+    inline void set_deadline(clock::time_point tp) {
+        csp_set_deadline(tp.time_since_epoch().count());
+    }
+
+    inline void clear_deadline() {
+        csp_set_deadline(INT64_MAX);
+    }
+
+    // An alt operand that fires at the given deadline, e.g.
+    // alt(in >> x, csp::deadline(tp)).
+    inline action deadline(clock::time_point tp) {
+        auto ns = intptr_t(tp.time_since_epoch().count());
+        return {csp_chanop{csp_wait_timeout, reinterpret_cast<void *>(ns)}, nullptr};
+    }
+
+    // An alt operand that fires after the given duration, e.g.
+    // alt(in >> x, csp::timeout(5ms)).  Unlike after(), it spawns nothing.
+    inline action timeout(clock::duration d) {
+        return deadline(clock::now() + d);
+    }
+
+    // Return a reader that fires once after the given duration. Dropping
+    // the reader cancels the timer and ends its producer at once.
     inline reader<> after(clock::duration d) {
-        return spawn_producer<poke_t>([d](writer<> w) {
-            csp::sleep(d);
-            w << poke;
+        auto tp = clock::now() + d;
+        return spawn_producer<poke_t>([tp](writer<> w) {
+            if (prialt(deadline(tp), ~w) == 1) {
+                w << poke;
+            }
         });
     }
 
     // Return a reader that fires repeatedly at the given interval,
     // delivering the current time. Uses absolute deadlines to prevent drift.
+    // Dropping the reader cancels the pending tick.
     inline reader<clock::time_point> tick(clock::duration interval) {
         return spawn_producer<clock::time_point>([interval](writer<clock::time_point> w) {
             auto next = clock::now() + interval;
-            while (true) {
-                csp::sleep_until(next);
-                if (!(w << clock::now())) break;
+            while (prialt(deadline(next), ~w) == 1 && (w << clock::now())) {
                 next += interval;
             }
         });
     }
 
+    // Like tick(), but every subscriber with the same interval in a runtime
+    // shares one producer and one timer, and ticks at the same instants.
+    // A subscriber that isn't reading when a tick fires misses it, so a
+    // slow one never holds up the rest.  The producer exits at the first
+    // tick after its last subscriber is dropped.
+    reader<clock::time_point> shared_tick(clock::duration interval);
+
 }
 
 #endif // INCLUDED__csp__timer_h
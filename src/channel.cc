@@ -15,6 +15,8 @@
 #include <exception>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <numeric>
 #include <random>
@@ -49,15 +51,18 @@ auto & counterses() {
 namespace {
 
     class Channel;
+    class SelectSet;
 
     struct ChanopWaiter {
         csp_chanop const * chanop;
         Microthread * thread;
+        SelectSet * set;            // Non-null for a select set's entry
 
         bool operator==(ChanopWaiter const & cw) const { return chanop == cw.chanop && thread == cw.thread; }
         bool operator!=(ChanopWaiter const & cw) const { return !(*this == cw); }
 
-        ChanopWaiter(csp_chanop const * chanop, Microthread * thread) : chanop{chanop}, thread{thread} { }
+        ChanopWaiter(csp_chanop const * chanop, Microthread * thread, SelectSet * set = nullptr)
+            : chanop{chanop}, thread{thread}, set{set} { }
     };
 
 }
@@ -114,11 +119,154 @@ namespace {
         return chan(c.waiter);
     }
 
+    // A timeout operand: no channel, the deadline in the message.
+    bool is_timeout(csp_chanop const & c) {
+        return c.waiter == csp_wait_timeout;
+    }
+
+    int64_t timeout_ns(csp_chanop const & c) {
+        return int64_t(intptr_t(c.message));
+    }
+
     char const * describe(void * ch);
 
+    // The messages held by a buffered channel: a ring of type-erased
+    // slots, guarded by the channel's mu_.
+    class Buffer {
+    public:
+        Buffer(csp_msgtype const & type, size_t capacity)
+            : type_(type)
+            , capacity_(capacity)
+            , mask_(round_up_pow2(checked(capacity, type.size)) - 1)
+            , slots_(new std::max_align_t[((mask_ + 1) * type.size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)])
+        {
+        }
+
+        ~Buffer() {
+            while (!empty()) {
+                pop(nullptr);
+            }
+        }
+
+        // Also safe without mu_, as a hint.
+        bool empty() const { return count_.load(std::memory_order_relaxed) == 0; }
+        bool full() const { return count_.load(std::memory_order_relaxed) == capacity_; }
+
+        // Move *src into the back.
+        void push(void * src) {
+            auto n = count_.load(std::memory_order_relaxed);
+            type_.construct(src, slot(front_ + n));
+            count_.store(n + 1, std::memory_order_relaxed);
+        }
+
+        // Move the front into *dst (unless null), and drop it.
+        void pop(void * dst) {
+            auto p = slot(front_++);
+            count_.store(count_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+            if (dst) {
+                type_.take(p, dst);
+            }
+            type_.destroy(p);
+        }
+
+    private:
+        static size_t checked(size_t capacity, size_t size) {
+            if (capacity > std::numeric_limits<size_t>::max() / 4 / std::max<size_t>(size, 1)) {
+                throw std::length_error("channel capacity too large");
+            }
+            return capacity;
+        }
+
+        static size_t round_up_pow2(size_t n) {
+            size_t p = 1;
+            while (p < n) {
+                p <<= 1;
+            }
+            return p;
+        }
+
+        void * slot(size_t i) { return reinterpret_cast<char *>(slots_.get()) + (i & mask_) * type_.size; }
+
+        csp_msgtype type_;
+        size_t capacity_;
+        size_t mask_;
+        size_t front_ = 0;
+        std::atomic<size_t> count_{0};      // Written under mu_
+        std::unique_ptr<std::max_align_t[]> slots_;
+    };
+
+    // A persistent alt (csp_select).  Its entries stay registered on
+    // their channels between waits, as ChanopWaiters tagged with the
+    // set.  A peer claims the set rather than its microthread, and only
+    // while the owner waits on it.  A peer that finds the set busy
+    // queues the entry on ready_ instead, so each wait tries only
+    // queued entries.  Each entry holds a reference to its endpoint, so
+    // its channel outlives the registration however the caller's own
+    // references go.  Only the owner adds, removes and waits; mu_
+    // guards ready_ and the queued flags.
+    class SelectSet {
+    public:
+        struct Entry {
+            csp_chanop chop;    // First, so a registered chanop finds its Entry
+            int id;
+            bool queued = false;
+        };
+
+        explicit SelectSet(Microthread * owner) : owner_(owner) { }
+        ~SelectSet();
+
+        SelectSet(SelectSet const &) = delete;
+        SelectSet & operator=(SelectSet const &) = delete;
+
+        int add(csp_chanop const & chop);
+        void remove(int id);
+        int wait(bool nowait);
+
+        static Entry & entry(csp_chanop const * chop) {
+            return *reinterpret_cast<Entry *>(const_cast<csp_chanop *>(chop));
+        }
+
+        // Claim the set for a rendezvous on chop, one of its entries.
+        // If the owner isn't waiting, queue the entry instead.
+        bool claim(csp_chanop const * chop) {
+            uint32_t expected = Microthread::ALT_WAITING;
+            if (state_.compare_exchange_strong(expected, Microthread::ALT_CLAIMED)) {
+                return true;
+            }
+            std::lock_guard<Mutex> lock(mu_);
+            enqueue(entry(chop));
+            // The owner may have gone to sleep since: wake it to look.
+            expected = Microthread::ALT_WAITING;
+            if (state_.compare_exchange_strong(expected, Microthread::ALT_CLAIMED)) {
+                owner_->signal_ = 0;
+                owner_->schedule();
+            }
+            return false;
+        }
+
+    private:
+        // Unregister e and drop its endpoint reference.
+        static void drop(Entry & e);
+
+        // Caller holds mu_.
+        void enqueue(Entry & e) {
+            if (!e.queued) {
+                e.queued = true;
+                ready_.push_back(&e);
+            }
+        }
+
+        Microthread * owner_;
+        std::atomic<uint32_t> state_{Microthread::ALT_IDLE};
+        Mutex mu_;
+        std::vector<std::unique_ptr<Entry>> entries_;   // By id - 1; null when free
+        std::deque<Entry *> ready_;
+    };
+
     class Channel {
     public:
-        Channel(void (* tx)(void * src, void * dst)) : tx_(tx) {     CSP_LOG(g_verboselog, "new (%s[%zu:%zu]) Channel", describe(this), endpts_[0].refcount.load(), endpts_[1].refcount.load());
+        Channel(void (* tx)(void * src, void * dst), csp_msgtype const * type = nullptr, size_t capacity = 0)
+            : buf_(capacity ? new Buffer(*type, capacity) : nullptr), tx_(tx) {     CSP_LOG(g_verboselog, "new (%s[%zu:%zu]) Channel", describe(this), endpts_[0].refcount.load(), endpts_[1].refcount.load());
             static_assert(offsetof(Channel,delegate_) == 0, "delegate_ must be at the start for chan() to work");
             // Must be 16-byte aligned.
             assert(((uintptr_t)this % 16) == 0);
@@ -140,32 +288,35 @@ namespace {
         }
         void release(int endpt) {                                   CSP_LOG(g_verboselog, "%s[%zu:%zu]->release(%c)", describe(this), endpts_[0].refcount.load() - (endpt == 0), endpts_[1].refcount.load() - (endpt == 1), "wr"[endpt]);
             ++counterses()[endpt].derefs;
-            if (endpts_[endpt].refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // seq_cst: a parking handoff() must see this or be seen.
+            if (endpts_[endpt].refcount.fetch_sub(1, std::memory_order_seq_cst) == 1) {
                 {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<Mutex> lock(mu_);
                     --counterses()[endpt].active;
                     auto & ep = endpts_[1 - endpt];
                     if (ep.refcount.load(std::memory_order_acquire) > 0) {
                         // Wake waiters via CAS. Don't remove from queues —
                         // woken threads clean up their own registrations.
                         for (auto const & cw : ep.waiters) {        CSP_LOG(g_verboselog, "%s: wake(%s) count=%zu", describe(this), getstatus(cw.thread), ep.waiters.count());
-                            uint32_t expected = Microthread::ALT_WAITING;
-                            if (cw.thread->alt_state.compare_exchange_strong(expected, Microthread::ALT_CLAIMED)) {
-                                int idx = int(cw.chanop - cw.thread->chanops_ + 1);
-                                cw.thread->signal_ = -idx;
+                            if (claim(cw)) {
+                                cw.thread->signal_ = -index_of(cw);
                                 cw.thread->schedule();
                             }
                         }
 
                         for (auto const & cv : ep.vultures) {
-                            uint32_t expected = Microthread::ALT_WAITING;
-                            if (cv.thread->alt_state.compare_exchange_strong(expected, Microthread::ALT_CLAIMED)) {
-                                int idx = int(cv.chanop - cv.thread->chanops_ + 1);
-                                cv.thread->signal_ = -idx;
+                            if (claim(cv)) {
+                                cv.thread->signal_ = -index_of(cv);
                                 cv.thread->schedule();
                             }
                         }
                         // Don't clear — woken threads clean up their own registrations.
+
+                        if (auto peer = unpark(1 - endpt)) {       CSP_LOG(g_verboselog, "%s: wake parked(%s)", describe(this), getstatus(peer->thread));
+                            auto thread = peer->thread;
+                            thread->signal_ = -1;
+                            thread->schedule();
+                        }
                     }
                 }
                 // Both endpoint sides decrement alive_. The last one
@@ -180,18 +331,118 @@ namespace {
 
         explicit operator bool() { return endpts_[wr].refcount.load() > 0 && endpts_[rd].refcount.load() > 0; }
 
+        // Register (or unregister) a select set's entry.  While it is
+        // registered, handoff() stays off this channel, as for a locked
+        // prialt.
+        void enlist(csp_chanop const * chop, SelectSet * set) {
+            std::lock_guard<Mutex> lock(mu_);
+            if (!buf_) {
+                queued_.fetch_add(1, std::memory_order_seq_cst);
+            }
+            endpts_[(uintptr_t)chop->waiter & csp_endpt_flag].wait(chop, set);
+        }
+
+        void delist(csp_chanop const * chop) {
+            std::lock_guard<Mutex> lock(mu_);
+            endpts_[(uintptr_t)chop->waiter & csp_endpt_flag].remove(chop, g_self);
+            if (!buf_) {
+                queued_.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        // Complete chop now if a peer lets it, as in phase 1 of prialt.
+        int attempt(csp_chanop const & chop) {
+            mu_.lock();
+            int result = attempt(chop, [this]{ mu_.unlock(); });
+            if (!result) {
+                mu_.unlock();
+            }
+            return result;
+        }
+
         static int alt(csp_chanop const * chanops, int count, bool nowait) {
             if (count == 1) {
                 return prialt(chanops, count, nowait);
             }
-            thread_local std::mt19937 rng{std::random_device{}()};
-            int offset = std::uniform_int_distribution<int>(0, count - 1)(rng);
+            // Fairness only needs a cheap, well-spread rotation: xorshift32,
+            // scaled to [0, count) by multiplication.
+            thread_local uint32_t x = std::random_device{}() | 1;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            int offset = int(uint64_t(x) * uint32_t(count) >> 32);
             return prialt(chanops, count, nowait, offset);
         }
 
         static int prialt(csp_chanop const * chanops, int count, bool nowait, int offset = 0) {
             /* */                                                   CSP_LOG(g_verboselog, "prialt%s(..., %d)", nowait ? "<nowait>" : "", count);
 
+            if (count == 1) {
+                if (Channel * ch = chan(chanops[0])) {
+                    int result = ch->handoff(chanops[0], nowait);
+                    if (result != locked) {
+                        return result;
+                    }
+                }
+            }
+
+            // Phase 1: Scan for ready peer (priority order, rotated by offset).
+            // A passed timeout counts as ready; otherwise note the earliest.
+            // Unless the channels are all locked, lock each one only to
+            // confirm a likely peer (maybe_ready()) and complete there.
+            bool all_null = true;
+            int timeout = 0;
+            int64_t deadline = INT64_MAX, now = 0;
+            auto scan = [&](bool locked, auto && unlock_all) {
+                all_null = true;
+                timeout = 0;
+                deadline = INT64_MAX;
+                for (int k = 0 ; k < count ; ++k) {
+                    int i = (offset + k) % count;
+                    auto const & chop = chanops[i];
+                    if (is_timeout(chop)) {
+                        if (!now) {
+                            now = now_ns();
+                        }
+                        if (timeout_ns(chop) <= now) {
+                            unlock_all();
+                            return i + 1;
+                        }
+                        if (timeout_ns(chop) < deadline) {
+                            deadline = timeout_ns(chop);
+                            timeout = i + 1;
+                        }
+                        all_null = false;
+                    } else if (Channel * ch = chan(chop)) {
+                        all_null = false;
+                        if (locked) {
+                            if (int result = ch->attempt(chop, unlock_all)) {
+                                return result * (i + 1);
+                            }
+                        } else if (ch->maybe_ready(chop)) {
+                            ch->mu_.lock();
+                            if (int result = ch->attempt(chop, [ch]{ ch->mu_.unlock(); })) {
+                                return result * (i + 1);
+                            }
+                            ch->mu_.unlock();
+                        }
+                    }
+                }
+                return 0;
+            };
+
+            // Most alts find a peer ready: don't lock (or even sort) the
+            // rest.  Only a blocking alt locks everything, to scan again
+            // and register.
+            if (count > 1) {
+                if (int result = scan(false, []{ })) {
+                    return result;
+                }
+                if (all_null || nowait) {                           CSP_LOG(g_verboselog, "prialt() -> %d", 0);
+                    return 0;
+                }
+            }
+
             // Collect unique channels, sorted by id for lock ordering.
             Channel* fixed_chans[8];
             std::vector<Channel*> variable_chans;
@@ -211,8 +462,18 @@ namespace {
                     }
                 }
             }
-            std::sort(sorted, sorted + n_sorted,
-                      [](Channel * a, Channel * b) { return a->id_ < b->id_; });
+            // Alts are mostly small, and insertion sort beats std::sort
+            // on a handful of elements.
+            auto by_id = [](Channel * a, Channel * b) { return a->id_ < b->id_; };
+            if (n_sorted <= 8) {
+                for (int i = 1; i < n_sorted; ++i) {
+                    for (int j = i; j > 0 && by_id(sorted[j], sorted[j - 1]); --j) {
+                        std::swap(sorted[j], sorted[j - 1]);
+                    }
+                }
+            } else {
+                std::sort(sorted, sorted + n_sorted, by_id);
+            }
             n_sorted = int(std::unique(sorted, sorted + n_sorted) - sorted);
 
             auto lock_all = [&]{ for (int i = 0; i < n_sorted; ++i) sorted[i]->mu_.lock(); };
@@ -220,60 +481,39 @@ namespace {
 
             lock_all();
 
-            // Phase 1: Scan for ready peer (priority order, rotated by offset).
-            bool all_null = true;
+            if (int result = scan(true, unlock_all)) {
+                return result;
+            }
+            if (all_null || nowait) {                               CSP_LOG(g_verboselog, "prialt() -> %d", 0);
+                unlock_all();
+                return 0;
+            }
+
+            // Announce ourselves before a last look for parked peers: a
+            // handoff() that parks from here on sees us and backs off.
+            auto dequeue = [&]{
+                for (int i = 0; i < n_sorted; ++i) {
+                    if (!sorted[i]->buf_) sorted[i]->queued_.fetch_sub(1, std::memory_order_release);
+                }
+            };
+            for (int i = 0; i < n_sorted; ++i) {
+                if (!sorted[i]->buf_) sorted[i]->queued_.fetch_add(1, std::memory_order_seq_cst);
+            }
             for (int k = 0 ; k < count ; ++k) {
                 int i = (offset + k) % count;
                 auto const & chop = chanops[i];
-                if (Channel * ch = chan(chop)) {
-                    auto flags = (uintptr_t)chop.waiter;
+                auto flags = (uintptr_t)chop.waiter;
+                Channel * ch = chan(chop);
+                if (ch && (flags & csp_ready_flag)) {
                     int endpt = flags & csp_endpt_flag;
-
-                    if (!*ch) {
-                        unlock_all();
-                        return -(i + 1);
+                    if (auto peer = ch->unpark(1 - endpt)) {
+                        dequeue();
+                        ch->meet(chop, endpt, *peer, unlock_all);
+                        return i + 1;
                     }
-
-                    auto & them = ch->endpts_[1 - endpt].waiters;
-                    if ((flags & csp_ready_flag)) {
-                        for (auto & cw : them) {
-                            uint32_t expected = Microthread::ALT_WAITING;
-                            if (cw.thread->alt_state.compare_exchange_strong(expected, Microthread::ALT_CLAIMED)) {
-                                int idx = int(cw.chanop - cw.thread->chanops_ + 1);
-                                cw.thread->signal_ = idx;
-                                if (endpt == wr) {                          CSP_LOG(g_verboselog, "PUSH %p[%p] -%p-> %p[%p]", ch, &chop.message, chop.message, cw.thread, &cw.chanop->message);
-                                    ;                                       if (g_sequence) { std::cerr << g_self->id_ << " -> " << cw.thread->id_ << " : " << describe(ch) << "\n"; }
-                                    if (auto dst = const_cast<void *>(cw.chanop->message)) {
-                                        ch->tx_(chop.message, dst);
-                                    }
-                                    if (Runtime::instance().procs.size() > 1) {
-                                        cw.thread->schedule();
-                                        unlock_all();
-                                    } else {
-                                        unlock_all();
-                                        cw.thread->run(Status::run);
-                                    }
-                                } else {                                    CSP_LOG(g_verboselog, "PULL %p[%p] -%p-> %p[%p]", cw.thread, &cw.chanop->message, cw.chanop->message, ch, &chop.message);
-                                    ;                                       if (g_sequence) { std::cerr << g_self->id_ << " <- " << cw.thread->id_ << " : " << describe(ch) << "\n"; }
-                                    if (auto dst = const_cast<void *>(chop.message)) {
-                                        ch->tx_(cw.chanop->message, dst);
-                                    }
-                                    cw.thread->schedule();
-                                    unlock_all();
-                                }
-                                return i + 1;
-                            }
-                        }
-                    }
-                    all_null = false;
                 }
             }
 
-            if (all_null || nowait) {                               CSP_LOG(g_verboselog, "prialt() -> %d", 0);
-                unlock_all();
-                return 0;
-            }
-
             // Phase 2: Register on all channels and sleep.
             g_self->alt_state.store(Microthread::ALT_WAITING, std::memory_order_release);
             for (int i = 0; i < count; ++i) {
@@ -295,12 +535,18 @@ namespace {
             // the global queue and a worker could run us while we
             // haven't finished suspending — double execution.
             g_self->suspending_.store(true, std::memory_order_release);
+            if (timeout) {
+                g_self->arm_timer(deadline, timeout);
+            }
             unlock_all();
             do_switch(Status::detach);
             g_self->suspending_.store(false, std::memory_order_release);
                                                                     CSP_LOG(g_sleeplog, "prialt() awoken -> %d", g_self->signal_);
 
             // Phase 3: Woken up — clean up registrations under sorted locks.
+            if (timeout) {
+                g_self->cancel_timer();
+            }
             lock_all();
             for (int i = 0; i < g_self->n_chanops_; ++i) {
                 auto const & chop = g_self->chanops_[i];
@@ -309,6 +555,7 @@ namespace {
                     ch->endpts_[flags & csp_endpt_flag].remove(&chop, g_self);
                 }
             }
+            dequeue();
             unlock_all();
 
             g_self->alt_state.store(Microthread::ALT_IDLE, std::memory_order_release);
@@ -319,6 +566,251 @@ namespace {
         }
 
     private:
+        // handoff()'s verdict when only the locked path will do.
+        static constexpr int locked = std::numeric_limits<int>::min();
+
+        // Lock-free point-to-point rendezvous.  A lone ready chanop on an
+        // unbuffered channel with one writer and one reader reference
+        // meets its peer through parked_, without mu_: it claims a parked
+        // peer with a CAS, or parks itself there and sleeps.  Anything
+        // else (a buffered channel, another endpoint copy, a locked
+        // prialt queued on the channel) returns `locked`.  A locked
+        // prialt counts itself into queued_ before its last look at
+        // parked_, and a parker re-checks queued_ and its peer's
+        // refcount after parking, so one side always sees the other.
+        int handoff(csp_chanop const & chop, bool nowait) {
+            auto flags = (uintptr_t)chop.waiter;
+            int endpt = flags & csp_endpt_flag;
+            if (!(flags & csp_ready_flag) || buf_
+                || endpts_[wr].refcount.load(std::memory_order_relaxed) != 1
+                || endpts_[rd].refcount.load(std::memory_order_relaxed) != 1
+                || queued_.load(std::memory_order_seq_cst) != 0) {
+                return locked;
+            }
+
+            if (auto parked = parked_.load(std::memory_order_acquire)) {
+                auto peer = int(parked & csp_endpt_flag) != endpt ? unpark(1 - endpt) : nullptr;
+                if (!peer) {
+                    return locked;
+                }
+                meet(chop, endpt, *peer, []{ });
+                return 1;
+            }
+            if (nowait) {
+                return 0;
+            }
+
+            // We may resume on another OS thread, where the g_self we
+            // read would be stale: hold on to ourselves.
+            Microthread * thread = g_self;
+            ChanopWaiter self{&chop, thread};
+            thread->alt_state.store(Microthread::ALT_WAITING, std::memory_order_release);
+            thread->chanops_ = &chop;
+            thread->n_chanops_ = 1;
+            thread->suspending_.store(true, std::memory_order_release);
+            auto leave = [thread]{
+                thread->suspending_.store(false, std::memory_order_release);
+                thread->alt_state.store(Microthread::ALT_IDLE, std::memory_order_release);
+                thread->chanops_ = nullptr;
+                thread->n_chanops_ = 0;
+            };
+
+            auto const me = uintptr_t(&self) | uintptr_t(endpt);
+            uintptr_t expected = 0;
+            if (!parked_.compare_exchange_strong(expected, me, std::memory_order_seq_cst)) {
+                leave();
+                return locked;
+            }
+            if (queued_.load(std::memory_order_seq_cst) != 0
+                || endpts_[1 - endpt].refcount.load(std::memory_order_seq_cst) == 0) {
+                // Someone may have missed us.  Withdraw, unless they've
+                // already claimed us.
+                expected = me;
+                if (parked_.compare_exchange_strong(expected, 0, std::memory_order_seq_cst)) {
+                    leave();
+                    return locked;
+                }
+            }
+            /* */                                                   CSP_LOG(g_sleeplog, "handoff() sleep");
+            do_switch(Status::detach);
+            auto result = thread->signal_;
+            leave();
+            return result;
+        }
+
+        // Complete chop now if a peer (or the buffer) lets it: call
+        // unlock and return 1, or -1 if the channel is dead.  Otherwise
+        // return 0, still locked.  Caller holds mu_.
+        template <typename Unlock>
+        int attempt(csp_chanop const & chop, Unlock && unlock) {
+            auto flags = (uintptr_t)chop.waiter;
+            int endpt = flags & csp_endpt_flag;
+
+            // Held messages outlive the writer.
+            if (buf_ && endpt == rd && (flags & csp_ready_flag) && !buf_->empty()) {
+                take(const_cast<void *>(chop.message));
+                unlock();
+                return 1;
+            }
+
+            if (!*this) {
+                unlock();
+                return -1;
+            }
+
+            if ((flags & csp_ready_flag)) {
+                if (auto peer = unpark(1 - endpt)) {
+                    meet(chop, endpt, *peer, unlock);
+                    return 1;
+                }
+                for (auto & cw : endpts_[1 - endpt].waiters) {
+                    if (claim(cw)) {
+                        meet(chop, endpt, cw, unlock);
+                        return 1;
+                    }
+                }
+                // No reader waiting (or the buffer would be empty and it
+                // would have taken the message): hold it.
+                if (buf_ && endpt == wr && !buf_->full()) {         CSP_LOG(g_verboselog, "HOLD %p[%p] -%p->", this, &chop.message, chop.message);
+                    buf_->push(chop.message);
+                    unlock();
+                    return 1;
+                }
+            }
+            return 0;
+        }
+
+        // Whether attempt(chop) might succeed, judged without mu_.
+        bool maybe_ready(csp_chanop const & chop) {
+            auto flags = (uintptr_t)chop.waiter;
+            int endpt = flags & csp_endpt_flag;
+            if (!*this) {
+                return true;
+            }
+            if (!(flags & csp_ready_flag)) {
+                return false;
+            }
+            if (buf_ && (endpt == rd ? !buf_->empty() : !buf_->full())) {
+                return true;
+            }
+            auto parked = parked_.load(std::memory_order_acquire);
+            return (parked && int(parked & csp_endpt_flag) != endpt)
+                || endpts_[1 - endpt].n_waiting.load(std::memory_order_acquire) > 0;
+        }
+
+        // Claim cw's waiting microthread (or select set) for a rendezvous.
+        static bool claim(ChanopWaiter const & cw) {
+            if (cw.set) {
+                return cw.set->claim(cw.chanop);
+            }
+            uint32_t expected = Microthread::ALT_WAITING;
+            return cw.thread->alt_state.compare_exchange_strong(expected, Microthread::ALT_CLAIMED);
+        }
+
+        // What a claimed waiter's wait returns: its chanop's index + 1,
+        // or its select set entry's id.
+        static int index_of(ChanopWaiter const & cw) {
+            if (cw.set) {
+                return SelectSet::entry(cw.chanop).id;
+            }
+            return int(cw.chanop - cw.thread->chanops_ + 1);
+        }
+
+        // Take the microthread parked on endpoint `endpt`, if any, and
+        // claim its alt.
+        ChanopWaiter * unpark(int endpt) {
+            // Check the tag, not the waiter: it lives on a stack that
+            // may have moved on by the time we look.
+            auto parked = parked_.load(std::memory_order_seq_cst);
+            if (!parked || int(parked & csp_endpt_flag) != endpt
+                || !parked_.compare_exchange_strong(parked, 0, std::memory_order_acq_rel)) {
+                return nullptr;
+            }
+            // Only whoever empties parked_ claims a parked microthread.
+            auto peer = reinterpret_cast<ChanopWaiter *>(parked & ~uintptr_t(csp_endpt_flag));
+            peer->thread->alt_state.store(Microthread::ALT_CLAIMED, std::memory_order_release);
+            return peer;
+        }
+
+        // Complete chop (on endpoint endpt) with peer, whose alt we have
+        // claimed: move the message and wake it, unlocking first.
+        template <typename Unlock>
+        void meet(csp_chanop const & chop, int endpt, ChanopWaiter const & peer, Unlock && unlock) {
+            auto thread = peer.thread;
+            thread->signal_ = index_of(peer);
+            if (endpt == wr) {                                      CSP_LOG(g_verboselog, "PUSH %p[%p] -%p-> %p[%p]", this, &chop.message, chop.message, thread, &peer.chanop->message);
+                ;                                                   if (g_sequence) { std::cerr << g_self->id_ << " -> " << thread->id_ << " : " << describe(this) << "\n"; }
+                if (auto dst = const_cast<void *>(peer.chanop->message)) {
+                    tx_(chop.message, dst);
+                }
+                // A buffered write needn't wait for the reader, so keep
+                // filling the buffer.
+                if (current_p().rt->threaded || buf_) {
+                    wake_peer(thread);
+                    unlock();
+                } else {
+                    unlock();
+                    thread->run(Status::run);
+                }
+            } else {                                                CSP_LOG(g_verboselog, "PULL %p[%p] -%p-> %p[%p]", thread, &peer.chanop->message, peer.chanop->message, this, &chop.message);
+                ;                                                   if (g_sequence) { std::cerr << g_self->id_ << " <- " << thread->id_ << " : " << describe(this) << "\n"; }
+                if (auto dst = const_cast<void *>(chop.message)) {
+                    tx_(peer.chanop->message, dst);
+                }
+                wake_peer(thread);
+                unlock();
+            }
+        }
+
+        // Pass the front held message to a reader, and refill its slot from
+        // the first writer blocked on the full buffer.  Caller holds mu_.
+        void take(void * dst) {                                     CSP_LOG(g_verboselog, "TAKE %p -> %p", this, dst);
+            buf_->pop(dst);
+            for (auto & cw : endpts_[wr].waiters) {
+                if (claim(cw)) {
+                    cw.thread->signal_ = index_of(cw);
+                    buf_->push(cw.chanop->message);
+                    wake_peer(cw.thread);
+                    return;
+                }
+            }
+        }
+
+        // Affinity hysteresis, in cross-processor rendezvous.
+        enum { affinity_on = 16, affinity_off = 8, affinity_backoff = 4 };
+
+        // Wake a claimed peer.  Count rendezvous whose peer
+        // last ran on another processor; once the channel proves chatty,
+        // wake peers onto our processor so the pair runs as local
+        // switches.  If the peer keeps turning up elsewhere anyway (work
+        // stealing moved it), back off.
+        void wake_peer(Microthread * peer) {
+            auto & p = current_p();
+            if (g_self != &p.main) {
+                bool cross = peer->last_p_ && peer->last_p_ != &p;
+                auto relaxed = std::memory_order_relaxed;
+                bool colocate = colocate_.load(relaxed);
+                if (!colocate) {
+                    if (cross && affinity_.fetch_add(1, relaxed) + 1 >= affinity_on) {
+                        ;                                           CSP_LOG(g_debug, "%s: colocating", describe(this));
+                        colocate_.store(colocate = true, relaxed);
+                    }
+                } else if (cross) {
+                    if (affinity_.fetch_sub(affinity_backoff, relaxed) - affinity_backoff <= affinity_off) {
+                        ;                                           CSP_LOG(g_debug, "%s: no longer colocating", describe(this));
+                        colocate_.store(colocate = false, relaxed);
+                    }
+                }
+                if (colocate) {
+                    if (peer->schedule_near(p)) {
+                        p.colocated_wakeups.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return;
+                }
+            }
+            peer->schedule();
+        }
+
         using Waiters = detail::RingBuffer<ChanopWaiter>;
         using Vultures = std::unordered_set<ChanopWaiter>;
 
@@ -328,18 +820,27 @@ namespace {
         size_t id_ = []{ static std::atomic<size_t> last{0}; return ++last; }();
         std::string descr_ = [this]{ char b[25]; snprintf(b, sizeof(b), "▸%lu", id_); return std::string(b); }();
         std::atomic<int> alive_{2};  // one per endpoint side; last to 0 deletes
-        std::mutex mu_;
+        Mutex mu_;
+        std::unique_ptr<Buffer> buf_;   // Buffered channels only
+        // Heuristic, so relaxed; handoff() wakes peers without mu_.
+        std::atomic<int> affinity_{0};
+        std::atomic<bool> colocate_{false};
+        std::atomic<uintptr_t> parked_{0};              // ChanopWaiter * | endpoint (see handoff())
+        std::atomic<int> queued_{0};                    // Locked prialts waiting here
         struct EndPoint {
             std::atomic<size_t> refcount{1};
             Waiters waiters;
+            std::atomic<size_t> n_waiting{0};   // waiters.count(), for maybe_ready()
             Vultures vultures;
 
-            void wait(csp_chanop const * chop) {                   CSP_LOG(g_verboselog, "wait(%s)", describe(chop->waiter));
+            void wait(csp_chanop const * chop, SelectSet * set = nullptr) {
+                                                                    CSP_LOG(g_verboselog, "wait(%s)", describe(chop->waiter));
                 auto flags = (uintptr_t)chop->waiter;
                 if (flags & csp_ready_flag) {
-                    waiters.emplace(chop, g_self);
+                    waiters.emplace(chop, g_self, set);
+                    n_waiting.store(waiters.count(), std::memory_order_release);
                 } else {
-                    vultures.emplace(chop, g_self);
+                    vultures.emplace(chop, g_self, set);
                 }
             }
 
@@ -348,6 +849,7 @@ namespace {
                 auto flags = (uintptr_t)chop->waiter;
                 if (flags & csp_ready_flag) {
                     waiters.remove({chop, t});
+                    n_waiting.store(waiters.count(), std::memory_order_release);
                 } else {
                     vultures.erase({chop, t});
                 }
@@ -365,6 +867,108 @@ namespace {
         return "▸Ø";
     }
 
+    void SelectSet::drop(Entry & e) {
+        Channel * ch = chan(e.chop);
+        ch->delist(&e.chop);
+        ch->release((uintptr_t)e.chop.waiter & csp_endpt_flag);
+    }
+
+    SelectSet::~SelectSet() {
+        for (auto & e : entries_) {
+            if (e) {
+                drop(*e);
+            }
+        }
+    }
+
+    int SelectSet::add(csp_chanop const & chop) {
+        Channel * ch = chan(chop);
+        if (!ch) {
+            return 0;
+        }
+        auto free = std::find(entries_.begin(), entries_.end(), nullptr);
+        if (free == entries_.end()) {
+            free = entries_.emplace(free);
+        }
+        int id = int(free - entries_.begin() + 1);
+        free->reset(new Entry{chop, id});
+        auto & e = **free;
+        ch->addref((uintptr_t)chop.waiter & csp_endpt_flag);
+        ch->enlist(&e.chop, this);
+        // A peer may already be waiting (or parked, from before we
+        // enlisted): look on the next wait.
+        std::lock_guard<Mutex> lock(mu_);
+        enqueue(e);
+        return id;
+    }
+
+    void SelectSet::remove(int id) {
+        if (id < 1 || id > int(entries_.size()) || !entries_[id - 1]) {
+            return;
+        }
+        auto & e = *entries_[id - 1];
+        drop(e);
+        {
+            std::lock_guard<Mutex> lock(mu_);
+            if (e.queued) {
+                ready_.erase(std::find(ready_.begin(), ready_.end(), &e));
+            }
+        }
+        entries_[id - 1].reset();
+    }
+
+    int SelectSet::wait(bool nowait) {
+        for (;;) {
+            Entry * e = nullptr;
+            {
+                std::lock_guard<Mutex> lock(mu_);
+                if (!ready_.empty()) {
+                    e = ready_.front();
+                    ready_.pop_front();
+                    e->queued = false;
+                } else if (nowait) {
+                    return 0;
+                } else {
+                    // As in prialt's phase 2: a claim may come before we
+                    // have switched away.
+                    owner_->suspending_.store(true, std::memory_order_release);
+                    owner_->signal_ = 0;
+                    state_.store(Microthread::ALT_WAITING, std::memory_order_seq_cst);
+                }
+            }
+
+            int result;
+            if (e) {
+                result = chan(e->chop)->attempt(e->chop) * e->id;
+                if (!result) {
+                    continue;
+                }
+            } else {                                                CSP_LOG(g_sleeplog, "select sleep");
+                do_switch(Status::detach);
+                owner_->suspending_.store(false, std::memory_order_release);
+                state_.store(Microthread::ALT_IDLE, std::memory_order_release);
+                result = owner_->signal_;                           CSP_LOG(g_sleeplog, "select awoken -> %d", result);
+                if (!result) {
+                    continue;
+                }
+                e = entries_[std::abs(result) - 1].get();
+            }
+
+            // A write has sent its message, and a moved-from message isn't
+            // worth sending again: it leaves the set.
+            if (result > 0 && !((uintptr_t)e->chop.waiter & csp_endpt_flag)) {
+                remove(e->id);
+                return result;
+            }
+
+            // Level-triggered: a channel with more peers (or a dead one)
+            // fires again on a later wait.
+            std::lock_guard<Mutex> lock(mu_);
+            enqueue(*e);
+            return result;
+        }
+    }
+
 }
 
 
@@ -387,6 +991,21 @@ int csp_chan(csp_writer * w, csp_reader * r, void (* tx)(void * src, void * dst)
     return int(false);
 }
 
+int csp_chan_buffered(csp_writer * w, csp_reader * r, void (* tx)(void * src, void * dst),
+                      csp_msgtype const * type, size_t capacity) {
+    try {
+        auto ch = new Channel{tx, type, capacity};
+        *w = ch->as_writer();
+        *r = ch->as_reader();
+        return int(true);
+    } catch (std::exception const & e) {
+        CSP_LOG(g_chlog, "csp_chan_buffered failed: %s", e.what());
+    } catch (...) {
+        CSP_LOG(g_chlog, "csp_chan_buffered failed: unknown exception");
+    }
+    return int(false);
+}
+
 void csp_chdescr(void * ch, char const * descr) {
     static bool enabled = false;
     if (enabled || (enabled = g_chlog || g_lifespan || g_msglog || g_sleeplog)) {
@@ -416,3 +1035,23 @@ int csp_alt(csp_chanop const * chanops, int count, int nowait) {
 int csp_prialt(csp_chanop const * chanops, int count, int nowait) {
     return Channel::prialt(chanops, count, bool(nowait));
 }
+
+csp_select csp_select_new(void) {
+    return reinterpret_cast<csp_select>(new SelectSet{g_self});
+}
+
+void csp_select_free(csp_select s) {
+    delete reinterpret_cast<SelectSet *>(s);
+}
+
+int csp_select_add(csp_select s, csp_chanop chop) {
+    return reinterpret_cast<SelectSet *>(s)->add(chop);
+}
+
+void csp_select_remove(csp_select s, int id) {
+    reinterpret_cast<SelectSet *>(s)->remove(id);
+}
+
+int csp_select_wait(csp_select s, int nowait) {
+    return reinterpret_cast<SelectSet *>(s)->wait(bool(nowait));
+}
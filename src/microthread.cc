@@ -74,21 +74,29 @@ namespace csp {
         // wake_pending_, but the drain clears suspending_ and checks
         // wake_pending_ in between (seeing false both times).
         static void drain_suspended(Microthread* suspended) {
-            auto& rt = Runtime::instance();
-            if (rt.procs.size() > 1) {
+            // Use the home runtime's global_mu, which is what schedule()
+            // takes, even when a wakeup comes from another pool.
+            auto rt = suspended->rt_;
+            if (rt && rt->threaded) {
                 bool need_unpark = false;
                 {
-                    std::lock_guard<std::mutex> lk(rt.global_mu);
+                    std::lock_guard<std::mutex> lk(rt->global_mu);
                     suspended->suspending_.store(false, std::memory_order_release);
                     if (suspended->wake_pending_.exchange(false, std::memory_order_acq_rel)) {
-                        if (!suspended->in_global_) {
-                            rt.push_to_global(suspended);
+                        if (auto pin = suspended->pin_) {
+                            std::lock_guard<Mutex> rlk(pin->run_mu);
+                            if (!suspended->next_) {
+                                pin->push(suspended);
+                                need_unpark = true;
+                            }
+                        } else if (!suspended->in_global_) {
+                            rt->push_to_global(suspended);
                             need_unpark = true;
                         }
                     }
                 }
                 if (need_unpark) {
-                    rt.unpark_one();
+                    rt->unpark_one();
                 }
             } else {
                 suspended->suspending_.store(false, std::memory_order_release);
@@ -119,8 +127,31 @@ namespace csp {
             return result;
         }
 
+        // Free a microthread that exited and chained into the caller via
+        // run(Status::exit).  Its stack can only be released once we are
+        // off it, i.e. here, on the stack of whoever it switched to.
+        static void reap(Microthread* killyou) {
+            if (!killyou) {
+                return;
+            }                                                           CSP_LOG(g_log, "kill %s (stk = %p)", getstatus(killyou), killyou->stk_);
+#if CSP_TSAN
+            if (killyou->tsan_fiber_) __tsan_destroy_fiber(killyou->tsan_fiber_);
+#endif
+            auto stk = killyou->stk_;
+            killyou->~Microthread();
+            delete [] stk;
+            auto& rt = Runtime::instance();
+            if (rt.live_gs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                // Lock park_mu briefly to synchronize with main_loop's
+                // wait, preventing missed notifications.
+                { std::lock_guard<std::mutex> lk(rt.park_mu); }
+                rt.park_cv.notify_all();
+            }
+        }
+
         Microthread::Microthread(fcontext_t ctx, StackSlot * stk) : ctx_(ctx), stk_(stk) {
             prev_ = next_ = nullptr;
+            timer_.thread = this;
             snprintf(status_, sizeof(status_), "§%lu", id_);
         }
 
@@ -130,30 +161,26 @@ namespace csp {
         }
 
         void Microthread::schedule_local(bool make_current) {
-            std::lock_guard<std::mutex> lk(current_p().run_mu);         CSP_LOG(g_busyq, "schedule_local %s [%s]", getstatus(this), qdescr(current_p().busy).c_str());
+            std::lock_guard<Mutex> lk(current_p().run_mu);         CSP_LOG(g_busyq, "schedule_local %s [%s]", getstatus(this), qdescr(current_p().busy).c_str());
             if (next_) {
                 return;
             }
-            auto& busy = current_p().busy;
-            if (busy) {
-                next_ = busy;
-                prev_ = busy->prev_;
-                next_->prev_ = prev_->next_ = this;
-                if (make_current) {
-                    busy = this;
-                }
-            } else {
-                busy = next_ = prev_ = this;
-            }                                                           CSP_LOG(g_busyq, "  busy = [%s]", qdescr(busy).c_str());
+            auto& p = current_p();
+            p.push(this);
+            if (make_current) {
+                p.busy = this;
+            }                                                           CSP_LOG(g_busyq, "  busy = [%s]", qdescr(p.busy).c_str());
         }
 
         void Microthread::schedule(bool make_current) {
-            auto& rt = Runtime::instance();
+            auto& rt = *rt_;
 
             // In M:N mode, push to the global run queue so any worker
             // can pick it up, preventing stranding on a P whose worker
-            // is about to park.
-            if (rt.procs.size() > 1) {
+            // is about to park.  Always the home runtime's queue: a
+            // microthread woken from another pool must not run there.
+            // A pinned microthread goes straight back to its dedicated P.
+            if (rt.threaded) {
                 {
                     std::lock_guard<std::mutex> lk(rt.global_mu);       CSP_LOG(g_busyq, "schedule %s -> global", getstatus(this));
                     if (in_global_) {
@@ -167,7 +194,15 @@ namespace csp {
                         wake_pending_.store(true, std::memory_order_release);
                         return;
                     }
-                    rt.push_to_global(this);
+                    if (pin_) {
+                        std::lock_guard<Mutex> rlk(pin_->run_mu);
+                        if (next_) {
+                            return;
+                        }
+                        pin_->push(this);
+                    } else {
+                        rt.push_to_global(this);
+                    }
                 }
                 rt.unpark_one();
                 return;
@@ -176,17 +211,64 @@ namespace csp {
             schedule_local(make_current);
         }
 
+        bool Microthread::schedule_near(Processor & p) {
+            // Affinity never moves work onto or off a dedicated P.
+            auto& rt = *rt_;
+            if (!rt.threaded || p.rt != &rt || p.dedicated || pin_) {
+                schedule();
+                return false;
+            }
+
+            // Same checks as schedule(), but link into p's queue instead
+            // of the global one.  p is the caller's processor, so its
+            // worker is awake and will reach us without an unpark.
+            std::lock_guard<std::mutex> lk(rt.global_mu);               CSP_LOG(g_busyq, "schedule %s -> P%d", getstatus(this), p.id);
+            if (in_global_) {
+                return false;
+            }
+            if (suspending_.load(std::memory_order_acquire)) {
+                wake_pending_.store(true, std::memory_order_release);
+                return false;
+            }
+            std::lock_guard<Mutex> rlk(p.run_mu);
+            if (next_) {
+                return false;
+            }
+            p.push(this);
+            return true;
+        }
+
         void Microthread::deschedule() {
-            std::lock_guard<std::mutex> lk(current_p().run_mu);         CSP_LOG(g_busyq, "deschedule %s", getstatus(this));
+            std::lock_guard<Mutex> lk(current_p().run_mu);         CSP_LOG(g_busyq, "deschedule %s", getstatus(this));
             assert(next_);
-            auto& busy = current_p().busy;
-            if (busy == this && (busy = next_) == this) {
-                busy = nullptr;
+            current_p().unlink(this);
+        }
+
+        void Microthread::arm_timer(int64_t deadline_ns, int signal, int64_t slack_ns) {
+            auto& p = current_p();
+            if (slack_ns < 0) {
+                slack_ns = p.rt ? p.rt->options.timer_slack.count() : 0;
+            }
+            {
+                std::lock_guard<Mutex> lk(p.timer_mu);
+                timer_.signal = signal;
+                timer_p_ = &p;
+                timer_armed_ = true;
+                p.timers.add(&timer_, deadline_ns, slack_ns);
+                p.timers_changed();
+            }
+            // p may be busy at the deadline; make sure someone watches.
+            if (p.rt && p.rt->threaded) {
+                p.rt->timer_armed(deadline_ns);
+            }
+        }
+
+        void Microthread::cancel_timer() {
+            auto& p = *timer_p_;
+            std::lock_guard<Mutex> lk(p.timer_mu);
+            if (p.timers.remove(&timer_)) {
+                p.timers_changed();
             }
-            if (next_) next_->prev_ = prev_;
-            if (prev_) prev_->next_ = next_;
-            next_ = nullptr;
-            prev_ = nullptr;
         }
 
         void Microthread::run(Status status) {                          CSP_LOG(g_inout, "/=== ENTER %s->Microthread::run(%s, %lu) ===", getstatus(g_self), getstatus(this), status);
@@ -198,7 +280,7 @@ namespace csp {
 
             // Manipulate run queue under lock, but release before context switch.
             {
-                std::lock_guard<std::mutex> lk(p.run_mu);
+                std::lock_guard<Mutex> lk(p.run_mu);
 
                 switch (status) {
                 case Status::run:
@@ -212,23 +294,11 @@ namespace csp {
                 case Status::exit:
                     // Inline deschedule without re-acquiring run_mu.
                     assert(g_self->next_);
-                    if (busy == g_self && (busy = g_self->next_) == g_self) {
-                        busy = nullptr;
-                    }
-                    if (g_self->next_) g_self->next_->prev_ = g_self->prev_;
-                    if (g_self->prev_) g_self->prev_->next_ = g_self->next_;
-                    g_self->next_ = nullptr;
-                    g_self->prev_ = nullptr;
+                    p.unlink(g_self);
 
                     if (status == Status::detach &&
                         g_self->wake_pending_.exchange(false, std::memory_order_acq_rel)) {
-                        if (busy) {
-                            g_self->next_ = busy;
-                            g_self->prev_ = busy->prev_;
-                            g_self->next_->prev_ = g_self->prev_->next_ = g_self;
-                        } else {
-                            busy = g_self->next_ = g_self->prev_ = g_self;
-                        }
+                        p.link(g_self);
                         return;
                     }
                     break;
@@ -237,35 +307,16 @@ namespace csp {
 
                 // Inline schedule without re-acquiring run_mu.
                 if (!next_) {
-                    if (busy) {
-                        next_ = busy;
-                        prev_ = busy->prev_;
-                        next_->prev_ = prev_->next_ = this;
-                    } else {
-                        busy = next_ = prev_ = this;
-                    }
+                    p.link(this);
                 }
             }
 
+            last_p_ = &p;
             auto killme = status == Status::exit ? g_self : nullptr;
                                                                         CSP_LOG(g_inout, "Switch to %s", getstatus(this));
             auto killyou = reinterpret_cast<Microthread *>(switch_to(*this, reinterpret_cast<intptr_t>(killme)));
                                                                         CSP_LOG(g_log, "jump_fcontext() → %s (%s)", killme ? getstatus(killme) : "-", getstatus(busy));
-            if (killyou) {                                              CSP_LOG(g_log, "kill %s (stk = %p)", getstatus(killyou), killyou->stk_);
-#if CSP_TSAN
-                if (killyou->tsan_fiber_) __tsan_destroy_fiber(killyou->tsan_fiber_);
-#endif
-                auto stk = killyou->stk_;
-                killyou->~Microthread();
-                delete [] stk;
-                auto& rt = Runtime::instance();
-                if (rt.live_gs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                    // Lock park_mu briefly to synchronize with main_loop's
-                    // wait, preventing missed notifications.
-                    { std::lock_guard<std::mutex> lk(rt.park_mu); }
-                    rt.park_cv.notify_all();
-                }
-            }                                                           CSP_LOG(g_busyq, "Busy queue: [%s]", qdescr(busy).c_str());
+            reap(killyou);                                              CSP_LOG(g_busyq, "Busy queue: [%s]", qdescr(busy).c_str());
                                                                         CSP_LOG(g_inout, "=== EXIT Microthread::run ===/");
 
             if (!killme) {
@@ -274,21 +325,43 @@ namespace csp {
         }
 
         void do_switch(Status status) {
+            auto& p = current_p();
+            auto& rt = *p.rt;
+            // Chains of switches need not come round to p.main, where
+            // worker_loop and csp_run start a round (EDF's pop and LIFO's
+            // run-next push may never do).  So refresh round_ns here too:
+            // on every switch while timers are armed, so that due ones
+            // fire, and otherwise every Processor::round_switches.  Don't
+            // fire while suspending on a timer of our own, though: were
+            // it due, we would run on ahead of timers due before it.
+            if (++p.switches >= Processor::round_switches || p.next_timer() != INT64_MAX) {
+                p.switches = 0;
+                p.round_ns = now_ns();
+                if (!g_self->timer_armed_) {
+                    rt.fire_timers(p);
+                }
+            }
+            if (rt.threaded && g_self != &p.main) {
+                rt.poll_global(p);
+            }
             Microthread* target;
             {
-                std::lock_guard<std::mutex> lk(current_p().run_mu);
+                std::lock_guard<Mutex> lk(p.run_mu);
                 // Update running to the active MT so steal_work skips it.
                 // (local_next sets running for the initial pick; chained
                 // do_switch calls keep it current as execution moves
                 // between microthreads.)
-                current_p().running = g_self;
-                auto& busy = current_p().busy;
+                p.running = g_self;
+                auto& busy = p.busy;
                 if (busy == g_self) {
                     busy = busy->next_;
                 }
+                busy = rt.pick(p, busy);
                 target = busy;
             }
+            rt.note_dispatch(p, target);
             target->run(status);
+            g_self->timer_armed_ = false;
         }
 
     }
@@ -338,19 +411,7 @@ static void start(transfer_t t) {
     // In M:N mode, the resuming switch may carry a killyou pointer — a
     // dying microthread that exited and chained into us via run(exit).
     // Clean it up before running our own function.
-    if (auto* killyou = reinterpret_cast<Microthread*>(killyou_val)) {
-#if CSP_TSAN
-        if (killyou->tsan_fiber_) __tsan_destroy_fiber(killyou->tsan_fiber_);
-#endif
-        auto stk = killyou->stk_;
-        killyou->~Microthread();
-        delete [] stk;
-        auto& rt = Runtime::instance();
-        if (rt.live_gs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-            { std::lock_guard<std::mutex> lk(rt.park_mu); }
-            rt.park_cv.notify_all();
-        }
-    }
+    reap(reinterpret_cast<Microthread*>(killyou_val));
 
     try {
         start_f(data);
@@ -361,15 +422,31 @@ static void start(transfer_t t) {
 };
 
 int csp_spawn(void (*start_f)(void *), void * data) {
+    return csp_spawn_on(nullptr, start_f, data);
+}
+
+int csp_spawn_on(csp_pool pool, void (*start_f)(void *), void * data) {
+    return csp_spawn_placed(pool, csp_place_default, start_f, data);
+}
+
+int csp_spawn_placed(csp_pool pool, int placement, void (*start_f)(void *), void * data) {
     (void)current_p(); // Ensure g_self is bound before use.
+    auto& home = pool ? *reinterpret_cast<Runtime *>(pool) : Runtime::instance();
+    if (!home.placeable(placement)) {
+        return 0;
+    }
     try {
         ;                                                               if (g_sequence) { static std::once_flag once; std::call_once(once, [] { std::cerr << "activate " << g_self->id_ << "\n"; }); }
         constexpr size_t S = Microthread::stack_size / 16;
         auto stk = new Microthread::StackSlot[S];
-        auto mt = (Microthread *)(stk + S) - 1;
+        // Place the microthread at the top of its stack, on a cache-line
+        // boundary so its hot scheduling fields share one line.
+        auto top = (uintptr_t)(stk + S) - sizeof(Microthread);
+        auto mt = (Microthread *)(top & ~uintptr_t(alignof(Microthread) - 1));
         assert(((uintptr_t)mt % 16) == 0); // Must be 16-byte aligned.
         auto ctx = make_fcontext(mt, (char *)mt - (char *)stk, start);
         new (mt) Microthread(ctx, stk);
+        mt->rt_ = &home;
 #if CSP_TSAN
         mt->tsan_fiber_ = __tsan_create_fiber(0);
 #endif
@@ -380,18 +457,16 @@ int csp_spawn(void (*start_f)(void *), void * data) {
         switch_to(*mt, reinterpret_cast<intptr_t>(&start_data));
         g_self = self;                                                  CSP_LOG(g_log, "started %s", getstatus(mt));
 
+        // live_gs counts microthreads in every pool, so schedule()
+        // waits for all of them.
         auto& rt = Runtime::instance();
         rt.live_gs.fetch_add(1, std::memory_order_relaxed);
 
-        if (rt.procs.size() > 1) {
+        if (home.threaded) {
             // M:N mode: after the handshake switch_to, mt is initialized
-            // and suspended but NOT on any run queue. Push it to the
-            // global queue for workers to pick up and run.
-            {
-                std::lock_guard<std::mutex> lk(rt.global_mu);
-                rt.push_to_global(mt);
-            }
-            rt.park_cv.notify_all();
+            // and suspended but NOT on any run queue. Queue it where the
+            // placement asks for workers to pick up and run.
+            home.place(mt, placement);
         } else {
             // Single-P mode: run the microthread on the main thread
             // (original behavior — run until it yields).
@@ -410,59 +485,131 @@ int csp_spawn(void (*start_f)(void *), void * data) {
 }
 
 void csp_sleep_until(int64_t deadline_ns) {
-    using namespace std::chrono;
-    auto deadline = steady_clock::time_point(nanoseconds(deadline_ns));
-    current_p().timer_heap.push({deadline, g_self});
+    csp_sleep_until_slack(deadline_ns, -1);
+}
+
+void csp_sleep_until_slack(int64_t deadline_ns, int64_t slack_ns) {
+    (void)current_p(); // Ensure g_self is bound before use.
+    // suspending_ first: an idle processor may fire the timer at once.
     g_self->suspending_.store(true, std::memory_order_release);
+    g_self->arm_timer(deadline_ns, 0, slack_ns);
     do_switch(Status::detach);
     g_self->suspending_.store(false, std::memory_order_release);
 }
 
-int csp_run() {
+void csp_set_deadline(int64_t deadline_ns) {
+    (void)current_p(); // Ensure g_self is bound before use.
+    g_self->deadline_ns_ = deadline_ns;
+}
+
+int64_t csp_now() {
+    return now_ns();
+}
+
+int64_t csp_coarse_now() {
+    // Only a microthread has a round to borrow from; the main sentinel's
+    // processor may not be scheduling at all.
+    if (auto self = g_self) {
+        auto& p = current_p();
+        if (self != &p.main && p.round_ns) {
+            return p.round_ns;
+        }
+    }
+    return now_ns();
+}
+
+void csp_blocking(void (* f)(void *), void * data) {
     auto& p = current_p();
-    auto& timer_heap = p.timer_heap;
+    auto& rt = *p.rt;
+    auto self = g_self;
+
+    // Single-P mode has nowhere to move the queue, and the main thread
+    // never hosts microthreads in M:N mode, so just call through.
+    if (!rt.threaded || self == &p.main) {
+        f(data);
+        return;
+    }
 
-    // Fire expired timers — reschedule their microthreads.
+    // This OS thread's native worker_loop context is saved in p.main.
+    // Carry it over to a private processor so we can return to it after
+    // f, then give p to another OS thread.  worker_main frees limbo once
+    // we're back.
+    auto& limbo = *new Processor{-1};
     {
-        auto now = std::chrono::steady_clock::now();
-        while (!timer_heap.empty() && timer_heap.top().deadline <= now) {
-            auto mt = timer_heap.top().thread;
-            timer_heap.pop();
-            mt->schedule_local();
-        }
+        std::lock_guard<Mutex> lk(p.run_mu);
+        p.unlink(self);
+        p.running = nullptr;
     }
+    limbo.main.ctx_.store(p.main.ctx_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    bind_processor(&limbo);
+    g_self = self;
+#if CSP_TSAN
+    limbo.main.tsan_fiber_ = p.main.tsan_fiber_;
+#endif
+    rt.blocking_calls.fetch_add(1, std::memory_order_acq_rel);
+    rt.handoff(p);                                                      CSP_LOG(g_log, "%s blocking; P%d handed off", getstatus(self), p.id);
+
+    f(data);
+    rt.blocking_calls.fetch_sub(1, std::memory_order_acq_rel);
+
+    // Queue ourselves for any processor, then drop back to the native
+    // stack.  schedule() only flags wake_pending_ while suspending_ is
+    // set; drain_suspended() pushes us to the global queue once our
+    // context is saved.
+    self->suspending_.store(true, std::memory_order_release);
+    self->schedule();
+    reap(reinterpret_cast<Microthread *>(switch_to(limbo.main, 0)));
+    g_self = self;
+    self->suspending_.store(false, std::memory_order_release);          CSP_LOG(g_log, "%s unblocked", getstatus(self));
+}
+
+int csp_run() {
+    auto& p = current_p();
+    auto& rt = *p.rt;
+
+    // Fire expired timers — reschedule their microthreads.
+    p.round_ns = now_ns();
+    rt.fire_timers(p);
 
     Microthread* target = nullptr;
     bool has_timers = false;
     {
-        std::lock_guard<std::mutex> lk(p.run_mu);
+        std::lock_guard<Mutex> lk(p.run_mu);
         auto& busy = p.busy;
         if (busy == g_self) {
             busy = busy->next_;                                         CSP_LOG(g_busyq, "skipped %s: [%s]", getstatus(g_self), qdescr(busy).c_str());
         }
         if (busy != g_self) {
+            busy = rt.pick(p, busy);
             target = busy;
         }
-        has_timers = !timer_heap.empty();
+        has_timers = !p.timers.empty();
     }
 
     if (target) {
+        rt.note_dispatch(p, target);
         target->run();
     } else if (has_timers) {
-        // All microthreads blocked, but timers pending — sleep until next deadline.
-        std::this_thread::sleep_until(timer_heap.top().deadline);
+        // All microthreads blocked, but timers pending — sleep until next
+        // deadline, or under virtual time, skip straight to it.
+        if (rt.options.virtual_time) {
+            advance_clock(p.next_timer());
+        } else {
+            std::this_thread::sleep_until(*rt.next_timer_deadline(p));
+            p.timer_wakeups.fetch_add(1, std::memory_order_relaxed);
+        }
     }
 
     {
-        std::lock_guard<std::mutex> lk(p.run_mu);
-        return p.busy->next_ != p.busy || !timer_heap.empty();
+        std::lock_guard<Mutex> lk(p.run_mu);
+        return p.busy->next_ != p.busy || !p.timers.empty();
     }
 }
 
 void csp_yield() {
     bool should_switch;
     {
-        std::lock_guard<std::mutex> lk(current_p().run_mu);
+        std::lock_guard<Mutex> lk(current_p().run_mu);
         auto& busy = current_p().busy;
         should_switch = busy->next_ != busy;
     }
@@ -12,13 +12,26 @@ namespace csp {
 
         thread_local Microthread * g_self = nullptr;
 
+        bool g_locking = true;
+
+        std::atomic<int64_t> g_clock_offset_ns{0};
+
+        void advance_clock(int64_t target_ns) {
+            auto skip = target_ns - now_ns();
+            if (skip > 0) {
+                g_clock_offset_ns.fetch_add(skip, std::memory_order_relaxed);
+            }
+        }
+
         static thread_local Processor * tl_proc_ = nullptr;
         static bool runtime_initialized_ = false;
 
         Processor& current_p() {
             if (!tl_proc_) {
                 if (!runtime_initialized_) {
-                    Runtime::instance().init(1);
+                    runtime_options opts;
+                    opts.num_procs = 1;
+                    Runtime::instance().init(opts);
                     runtime_initialized_ = true;
                 } else {
                     // Worker thread — bind_processor should have been called.
@@ -36,27 +49,86 @@ namespace csp {
 #endif
         }
 
+        void unbind_processor() {
+            tl_proc_ = nullptr;
+            g_self = nullptr;
+        }
+
     }
 
     void init_runtime(int num_procs) {
+        runtime_options opts;
+        opts.num_procs = num_procs;
+        init_runtime(opts);
+    }
+
+    void init_runtime(runtime_options const & options) {
+        if ((CSP_SINGLE_THREADED || options.single_threaded) && options.num_procs > 1) {
+            throw microthread_error("single-threaded runtime supports only one processor");
+        }
+        if (options.dedicated_procs < 0
+            || (options.dedicated_procs > 0 && options.num_procs > 0
+                && options.dedicated_procs >= options.num_procs - 1)) {
+            throw microthread_error("dedicated processors need a shared worker to spare");
+        }
         auto& rt = detail::Runtime::instance();
-        rt.init(num_procs);
+        rt.init(options);
         detail::runtime_initialized_ = true;
 
-        if (num_procs != 1) {
+        if (rt.threaded) {
             set_scheduler([&rt] {
                 rt.main_loop();
             });
         }
     }
 
+    pool create_pool(std::string const & name, int num_procs) {
+        runtime_options opts;
+        opts.num_procs = num_procs;
+        return create_pool(name, opts);
+    }
+
+    pool create_pool(std::string const & name, runtime_options const & options) {
+        if (!detail::Runtime::instance().threaded) {
+            throw microthread_error("scheduler pools need an M:N runtime (init_runtime)");
+        }
+        if (options.virtual_time) {
+            throw microthread_error("virtual time is process-wide; set it with init_runtime");
+        }
+        if (options.dedicated_procs < 0
+            || (options.dedicated_procs > 0 && options.num_procs > 0
+                && options.dedicated_procs >= options.num_procs)) {
+            throw microthread_error("dedicated processors need a shared worker to spare");
+        }
+        auto rt = detail::Runtime::create_pool(name, options);
+        if (!rt) {
+            throw microthread_error("pool already exists: " + name);
+        }
+        return reinterpret_cast<pool>(rt);
+    }
+
+    pool find_pool(std::string const & name) {
+        return reinterpret_cast<pool>(detail::Runtime::find_pool(name));
+    }
+
     void shutdown_runtime() {
         detail::Runtime::instance().shutdown();
         detail::runtime_initialized_ = false;
         detail::tl_proc_ = nullptr;
+        detail::g_locking = true;
 
         // Restore default single-threaded scheduler.
         set_scheduler([]{ while (csp_run()) { } });
     }
 
 }
+
+csp_pool csp_pool_create(char const * name, int num_procs) {
+    csp::runtime_options opts;
+    opts.num_procs = num_procs;
+    return reinterpret_cast<csp_pool>(csp::detail::Runtime::create_pool(name, opts));
+}
+
+csp_pool csp_pool_find(char const * name) {
+    return csp::find_pool(name);
+}
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <map>
 
 namespace csp {
 
@@ -9,22 +10,91 @@ namespace csp {
 
         static Runtime g_runtime;
 
+        static std::mutex g_pools_mu;
+        static std::map<std::string, std::unique_ptr<Runtime>> g_pools;
+
+        // Heap order for global_ranked: a comes out after b if b ranks
+        // before it, or ranks the same and was queued first.
+        struct RankedAfter {
+            run_queue_policy const & policy;
+            bool operator()(Runtime::Ranked const & a, Runtime::Ranked const & b) const {
+                if (policy.before(task(b.mt), task(a.mt))) {
+                    return true;
+                }
+                return !policy.before(task(a.mt), task(b.mt)) && a.seq > b.seq;
+            }
+        };
+
         Runtime& Runtime::instance() {
             return g_runtime;
         }
 
-        void Runtime::init(int num_procs) {
+        Runtime* Runtime::create_pool(std::string const & name,
+                                      runtime_options const & opts) {
+            // Microthreads on the default runtime must be woken through
+            // its global queue when a pool thread makes them runnable,
+            // which only happens in M:N mode.
+            if (!g_runtime.threaded) {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lk(g_pools_mu);
+            auto& slot = g_pools[name];
+            if (slot) {
+                return nullptr;
+            }
+            slot = std::make_unique<Runtime>();
+            slot->name = name;
+            slot->is_pool = true;
+            slot->init(opts);
+            return slot.get();
+        }
+
+        Runtime* Runtime::find_pool(std::string const & name) {
+            std::lock_guard<std::mutex> lk(g_pools_mu);
+            auto i = g_pools.find(name);
+            return i == g_pools.end() ? nullptr : i->second.get();
+        }
+
+        void Runtime::shutdown_pools() {
+            std::map<std::string, std::unique_ptr<Runtime>> pools;
+            {
+                std::lock_guard<std::mutex> lk(g_pools_mu);
+                pools.swap(g_pools);
+            }
+            for (auto& kv : pools) {
+                kv.second->shutdown();
+            }
+        }
+
+        void Runtime::init(runtime_options const & opts) {
             // Shut down any previous state.
             if (!procs.empty()) {
                 shutdown();
             }
 
+            options = opts;
+            policy = opts.queue_policy ? opts.queue_policy
+                                       : make_queue_policy(opts.policy);
+            int num_procs = opts.num_procs;
+
+            // Only the default runtime decides the locking mode; no
+            // Mutex is held while it changes.
+            if (!is_pool) {
+                g_locking = !CSP_SINGLE_THREADED && !opts.single_threaded;
+                if (!g_locking) {
+                    num_procs = 1;
+                }
+            }
+
             stopping.store(false, std::memory_order_release);
             live_gs.store(0, std::memory_order_release);
 
             {
                 std::lock_guard<std::mutex> lk(global_mu);
                 global_run_queue.clear();
+                global_ranked.clear();
+                global_len.store(0, std::memory_order_release);
+                max_global_wait_ns = 0;
             }
 
             if (num_procs <= 0) {
@@ -33,19 +103,41 @@ namespace csp {
 
             procs.reserve(num_procs);
             for (int i = 0; i < num_procs; ++i) {
-                procs.push_back(std::make_unique<Processor>(i));
+                procs.push_back(std::make_unique<Processor>(i, this));
+                procs.back()->timers.set_resolution_ns(opts.timer_resolution.count());
+            }
+
+            // The default runtime's P0 belongs to the calling (main)
+            // thread.  A pool runs microthreads on all of its Ps.
+            int first_worker = 0;
+            if (!is_pool) {
+                bind_processor(procs[0].get());
+                first_worker = 1;
+            }
+            threaded = is_pool || num_procs > 1;
+
+            // Reserve dedicated processors at the end, always leaving at
+            // least one shared worker for everything else.
+            int shared = num_procs - first_worker;
+            int reserved = std::max(0, std::min(opts.dedicated_procs, shared - 1));
+            first_dedicated = num_procs - reserved;
+            for (int i = first_dedicated; i < num_procs; ++i) {
+                procs[i]->dedicated = true;
             }
-            bind_processor(procs[0].get());
 
-            for (int i = 1; i < num_procs; ++i) {
-                workers.emplace_back([this, i] {
-                    bind_processor(procs[i].get());
-                    worker_loop();
+            std::lock_guard<std::mutex> lk(spare_mu);
+            for (int i = first_worker; i < num_procs; ++i) {
+                workers.emplace_back([this, p = procs[i].get()] {
+                    worker_main(p);
                 });
             }
         }
 
         void Runtime::shutdown() {
+            if (this == &g_runtime) {
+                shutdown_pools();
+            }
+
             stopping.store(true, std::memory_order_release);
             // Acquire-release park_mu to synchronize with workers'
             // park_cv.wait() — ensures any worker that has already
@@ -54,19 +146,45 @@ namespace csp {
             // notifications.
             { std::lock_guard<std::mutex> lk(park_mu); }
             park_cv.notify_all();
-
-            for (auto& w : workers) {
-                if (w.joinable()) {
-                    w.join();
+            timer_cv.notify_all();
+            { std::lock_guard<std::mutex> lk(spare_mu); }
+            spare_cv.notify_all();
+
+            // A worker may start a spare while we join, so keep going
+            // until no threads remain.
+            for (;;) {
+                std::vector<std::thread> joining;
+                {
+                    std::lock_guard<std::mutex> lk(spare_mu);
+                    joining.swap(workers);
+                    if (retired.joinable()) {
+                        joining.push_back(std::move(retired));
+                    }
+                }
+                if (joining.empty()) {
+                    break;
+                }
+                for (auto& w : joining) {
+                    if (w.joinable()) {
+                        w.join();
+                    }
                 }
             }
 
-            workers.clear();
+            orphans.clear();
+            idle_spares = 0;
+            {
+                // Their producers stopped with the workers.
+                std::lock_guard<std::mutex> lk(ticker_mu);
+                tickers.clear();
+            }
             procs.clear();
+            threaded = false;
         }
 
         void Runtime::unpark_one() {
             park_cv.notify_all();
+            timer_cv.notify_one();
         }
 
         void Runtime::push_to_global(Microthread* mt) {
@@ -74,20 +192,173 @@ namespace csp {
             assert(!mt->next_);
             assert(!mt->in_global_);
             mt->in_global_ = true;
-            global_run_queue.push_back(mt);
+            mt->global_since_ns_ = now_ns();
+            if (policy->ranks_global(task(mt))) {
+                global_ranked.push_back({mt, global_seq++});
+                std::push_heap(global_ranked.begin(), global_ranked.end(), RankedAfter{*policy});
+            } else {
+                global_run_queue.push_back(mt);
+            }
+            global_len.fetch_add(1, std::memory_order_release);
+        }
+
+        bool Runtime::placeable(int where) const {
+            // Vet the runtime's default as place() will use it.
+            if (where == csp_place_default) {
+                where = int(options.spawn_placement);
+            }
+            if (where == csp_place_dedicated) {
+                return !threaded || first_dedicated < (int)procs.size();
+            }
+            // The default runtime's P0 is the main thread, which never
+            // runs microthreads in M:N mode.
+            return where < 0 || !threaded
+                || (where >= (is_pool ? 0 : 1) && where < (int)procs.size());
+        }
+
+        void Runtime::place(Microthread* mt, int where) {
+            if (where == csp_place_default) {
+                where = int(options.spawn_placement);
+            }
+
+            Processor* target = nullptr;
+            bool run_next = false;
+            if (where == csp_place_local) {
+                // Only a microthread on one of our shared workers has a
+                // P to share; anyone else falls back to the global queue.
+                auto& p = current_p();
+                if (p.rt == this && !p.dedicated
+                    && g_self != &p.main && g_self->next_) {
+                    target = &p;
+                    run_next = true;
+                }
+            } else if (where == csp_place_spread) {
+                int first = is_pool ? 0 : 1;
+                int n = first_dedicated - first;
+                auto i = spread_next.fetch_add(1, std::memory_order_relaxed);
+                target = procs[first + i % n].get();
+            } else if (where == csp_place_dedicated) {
+                int n = (int)procs.size() - first_dedicated;
+                auto i = dedicated_next.fetch_add(1, std::memory_order_relaxed);
+                target = procs[first_dedicated + i % n].get();
+            } else if (where >= 0) {
+                target = procs[where].get();
+            }
+            if (target && target->dedicated) {
+                mt->pin_ = target;
+            }
+
+            if (!target) {
+                {
+                    std::lock_guard<std::mutex> lk(global_mu);
+                    push_to_global(mt);
+                }
+                unpark_one();
+                return;
+            }
+
+            {
+                std::lock_guard<Mutex> lk(target->run_mu);
+                if (run_next) {
+                    target->link_after(g_self, mt);
+                } else {
+                    target->push(mt);
+                }
+            }
+            // The spawner's own worker reaches a run-next child when the
+            // spawner yields; other targets may be parked.
+            if (!run_next) {
+                unpark_one();
+            }
+        }
+
+        void Runtime::handoff(Processor& p) {
+            std::lock_guard<std::mutex> lk(spare_mu);
+            orphans.push_back(&p);
+            if (idle_spares >= (int)orphans.size()) {
+                spare_cv.notify_one();
+            } else {
+                workers.emplace_back([this] { worker_main(nullptr); });
+            }
+        }
+
+        void Runtime::worker_main(Processor* p) {
+            for (;;) {
+                if (!p) {
+                    // Spare thread: wait for a processor to adopt, unless
+                    // enough spares wait already.  A quitting spare can't
+                    // join itself, so it leaves its handle for the next
+                    // one (or shutdown) to join.
+                    std::unique_lock<std::mutex> lk(spare_mu);
+                    if (orphans.empty() && idle_spares >= (int)procs.size()
+                        && !stopping.load(std::memory_order_acquire)) {
+                        auto self = std::find_if(workers.begin(), workers.end(), [](std::thread const & t) {
+                            return t.get_id() == std::this_thread::get_id();
+                        });
+                        std::thread prev;
+                        if (self != workers.end()) {
+                            prev = std::move(retired);
+                            retired = std::move(*self);
+                            workers.erase(self);
+                        }
+                        lk.unlock();
+                        if (prev.joinable()) {
+                            prev.join();
+                        }
+                        return;
+                    }
+                    ++idle_spares;
+                    spare_cv.wait(lk, [this] {
+                        return stopping.load(std::memory_order_acquire)
+                            || !orphans.empty();
+                    });
+                    --idle_spares;
+                    if (stopping.load(std::memory_order_acquire)) {
+                        return;
+                    }
+                    p = orphans.front();
+                    orphans.pop_front();
+                }
+
+                bind_processor(p);
+                worker_loop();
+                // Unless stopping, worker_loop only returns when a
+                // microthread on this thread entered csp_blocking and
+                // gave p away, leaving us bound to the limbo processor
+                // it made.
+                if (&current_p() != p) {
+                    delete &current_p();
+                    unbind_processor();
+                }
+                if (stopping.load(std::memory_order_acquire)) {
+                    return;
+                }
+                p = nullptr;
+            }
         }
 
         void Runtime::worker_loop() {
             auto& p = current_p();
 
             while (!stopping.load(std::memory_order_acquire)) {
+                // One clock read per round, shared by the timer check,
+                // deadline accounting and csp::clock::coarse_now().
+                p.round_ns = now_ns();
+
                 // Fire expired timers.
                 fire_timers(p);
 
+                poll_global(p);
+
                 // Try local run queue.
                 Microthread* next = local_next(p);
                 if (next) {
                     next->run();
+                    // A blocking call handed p to another thread and
+                    // switched back here once it finished.
+                    if (&current_p() != &p) {
+                        return;
+                    }
                     continue;
                 }
 
@@ -101,22 +372,56 @@ namespace csp {
                     continue;
                 }
 
+                // Fire timers that busy processors haven't got to.
+                if (fire_remote_timers(p)) {
+                    continue;
+                }
+
                 // Park: wait for work or shutdown.
                 {
                     std::unique_lock<std::mutex> lk(park_mu);
+                    if (options.virtual_time && skip_to_next_timer(p)) {
+                        continue;
+                    }
                     p.parked.store(true, std::memory_order_release);
 
                     auto deadline = next_timer_deadline(p);
+
+                    // The first shared worker to park also wakes for
+                    // other processors' timers, or for earlier ones
+                    // armed while it sleeps (timer_armed).  When it
+                    // leaves, another parked shared worker takes over.
+                    int64_t watch = INT64_MAX;
+                    bool watching = !p.dedicated && !timer_watcher;
+                    if (watching) {
+                        timer_watcher = true;
+                        watch = earliest_timer_ns();
+                        timer_watch_ns.store(watch, std::memory_order_release);
+                        if (watch != INT64_MAX) {
+                            auto tp = real_time(watch);
+                            deadline = deadline ? std::min(*deadline, tp) : tp;
+                        }
+                    }
+                    auto ready = [&] {
+                        return stopping.load(std::memory_order_acquire)
+                            || has_work(p)
+                            || (watching
+                                ? timer_watch_ns.load(std::memory_order_acquire) < watch
+                                : !p.dedicated && !timer_watcher);
+                    };
+                    auto& cv = watching ? timer_cv : park_cv;
                     if (deadline) {
-                        park_cv.wait_until(lk, *deadline, [this, &p] {
-                            return stopping.load(std::memory_order_acquire)
-                                || has_work(p);
-                        });
+                        cv.wait_until(lk, *deadline, ready);
+                        if (std::chrono::steady_clock::now() >= *deadline) {
+                            p.timer_wakeups.fetch_add(1, std::memory_order_relaxed);
+                        }
                     } else {
-                        park_cv.wait(lk, [this, &p] {
-                            return stopping.load(std::memory_order_acquire)
-                                || has_work(p);
-                        });
+                        cv.wait(lk, ready);
+                    }
+                    if (watching) {
+                        timer_watcher = false;
+                        timer_watch_ns.store(INT64_MIN, std::memory_order_release);
+                        park_cv.notify_all();
                     }
 
                     p.parked.store(false, std::memory_order_release);
@@ -128,13 +433,15 @@ namespace csp {
             // Main thread waits for all microthreads to complete.
             // Workers do all the actual execution.
             std::unique_lock<std::mutex> lk(park_mu);
+            main_waiting = true;
             park_cv.wait(lk, [this] {
                 return live_gs.load(std::memory_order_acquire) == 0;
             });
+            main_waiting = false;
         }
 
         Microthread* Runtime::local_next(Processor& p) {
-            std::lock_guard<std::mutex> lk(p.run_mu);
+            std::lock_guard<Mutex> lk(p.run_mu);
             auto& busy = p.busy;
             if (!busy) {
                 p.running = nullptr;
@@ -150,46 +457,182 @@ namespace csp {
                 p.running = nullptr;
                 return nullptr;
             }
+            candidate = pick(p, candidate);
             // Mark this MT as claimed so steal_work on other Ps skips it.
             p.running = candidate;
+            note_dispatch(p, candidate);
             return candidate;
         }
 
-        bool Runtime::take_from_global(Processor& p) {
+        void Runtime::poll_global(Processor& p) {
+            int interval = options.global_poll_interval;
+            if (interval > 0 && ++p.sched_tick >= (unsigned)interval) {
+                p.sched_tick = 0;
+                take_from_global(p, 1);
+            }
+        }
+
+        bool Runtime::take_from_global(Processor& p, int max) {
+            // Dedicated processors only run what is pinned to them.
+            if (p.dedicated) {
+                return false;
+            }
             std::lock_guard<std::mutex> lk(global_mu);
-            if (global_run_queue.empty()) {
+            int avail = int(global_run_queue.size() + global_ranked.size());
+            if (!avail) {
                 return false;
             }
 
-            // Take a fair share so other workers also get work.
-            int avail = (int)global_run_queue.size();
-            int n = std::max(1, avail / (int)procs.size());
+            // Take the policy's share (by default a fair one, so other
+            // workers also get work), each time the earlier of the ranked
+            // heap's top (e.g. EDF's most urgent) and the FIFO's head.
+            int n = std::min({max, avail,
+                              std::max(1, policy->take(avail, (int)procs.size()))});
+            auto now = now_ns();
             for (int i = 0; i < n; ++i) {
-                auto* mt = global_run_queue.front();
-                global_run_queue.pop_front();
+                Microthread* mt;
+                if (!global_ranked.empty()
+                    && (global_run_queue.empty()
+                        || !policy->before(task(global_run_queue.front()),
+                                           task(global_ranked.front().mt)))) {
+                    std::pop_heap(global_ranked.begin(), global_ranked.end(), RankedAfter{*policy});
+                    mt = global_ranked.back().mt;
+                    global_ranked.pop_back();
+                } else {
+                    mt = global_run_queue.front();
+                    global_run_queue.pop_front();
+                }
+                global_len.fetch_sub(1, std::memory_order_release);
                 mt->in_global_ = false;
+                max_global_wait_ns = std::max(max_global_wait_ns,
+                                              now - mt->global_since_ns_);
                 mt->schedule_local();
             }
             return true;
         }
 
         void Runtime::fire_timers(Processor& p) {
-            auto now = std::chrono::steady_clock::now();
-            while (!p.timer_heap.empty() && p.timer_heap.top().deadline <= now) {
-                auto* mt = p.timer_heap.top().thread;
-                p.timer_heap.pop();
-                mt->schedule_local();
+            if (p.next_timer() > p.round_ns) {
+                return;
+            }
+            std::lock_guard<Mutex> lk(p.timer_mu);
+            expire_timers(p, p.round_ns, false);
+        }
+
+        bool Runtime::fire_remote_timers(Processor& thief) {
+            if (thief.dedicated) {
+                return false;
+            }
+            auto now = thief.round_ns;
+            bool fired = false;
+            for (auto& victim_ptr : procs) {
+                auto& victim = *victim_ptr;
+                if (&victim == &thief || victim.dedicated
+                    || victim.next_timer_ns.load(std::memory_order_acquire) > now) {
+                    continue;
+                }
+                std::unique_lock<Mutex> lk(victim.timer_mu, std::try_to_lock);
+                if (!lk) continue;
+                auto pending = victim.timers.size();
+                expire_timers(victim, now, true);
+                if (victim.timers.size() < pending) {
+                    victim.remote_timer_fires.fetch_add(pending - victim.timers.size(),
+                                                        std::memory_order_relaxed);
+                    fired = true;
+                }
+            }
+            return fired;
+        }
+
+        void Runtime::expire_timers(Processor& p, int64_t now, bool remote) {
+            p.timers.expire(now, [&](TimerNode* n) {
+                auto late_us = uint64_t(now - n->deadline_ns) / 1000;
+                int bucket = late_us ? 64 - __builtin_clzll(late_us) : 0;
+                bucket = std::min(bucket, runtime_stats::timer_lateness_buckets - 1);
+                p.timer_lateness[bucket].fetch_add(1, std::memory_order_relaxed);
+
+                auto mt = n->thread;
+                if (n->signal) {
+                    // An alt timeout races the alt's channels; the loser
+                    // leaves the wake to the winner.
+                    uint32_t expected = Microthread::ALT_WAITING;
+                    if (!mt->alt_state.compare_exchange_strong(expected, Microthread::ALT_CLAIMED)) {
+                        return;
+                    }
+                    mt->signal_ = n->signal;
+                }
+                // A remote firer must not link mt locally: it may still be
+                // suspending on its own processor.  schedule() defers to
+                // drain_suspended in that case.
+                if (remote) {
+                    mt->schedule();
+                } else {
+                    mt->schedule_local();
+                }
+            });
+            p.timers_changed();
+        }
+
+        void Runtime::timer_armed(int64_t deadline_ns) {
+            auto watch = timer_watch_ns.load(std::memory_order_acquire);
+            while (deadline_ns < watch) {
+                if (timer_watch_ns.compare_exchange_weak(watch, deadline_ns)) {
+                    { std::lock_guard<std::mutex> lk(park_mu); }
+                    timer_cv.notify_one();
+                    return;
+                }
+            }
+        }
+
+        bool Runtime::skip_to_next_timer(Processor& self) {
+            // The main thread may still be spawning until it waits too.
+            if ((!is_pool && !main_waiting)
+                || blocking_calls.load(std::memory_order_acquire) > 0
+                || global_len.load(std::memory_order_acquire) > 0) {
+                return false;
+            }
+            int64_t next = INT64_MAX;
+            for (int i = is_pool ? 0 : 1; i < (int)procs.size(); ++i) {
+                auto& q = *procs[i];
+                if (&q != &self && !q.parked.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                if (q.queued.load(std::memory_order_acquire) > 0) {
+                    return false;
+                }
+                next = std::min(next, q.next_timer_ns.load(std::memory_order_acquire));
+            }
+            if (next == INT64_MAX || next <= now_ns()) {
+                return false;
             }
+            advance_clock(next);
+            park_cv.notify_all();
+            timer_cv.notify_all();
+            return true;
+        }
+
+        int64_t Runtime::earliest_timer_ns() const {
+            int64_t earliest = INT64_MAX;
+            for (auto& p : procs) {
+                if (!p->dedicated) {
+                    earliest = std::min(earliest, p->next_timer_ns.load(std::memory_order_acquire));
+                }
+            }
+            return earliest;
         }
 
         bool Runtime::steal_work(Processor& thief) {
+            // Dedicated processors neither steal nor are stolen from.
+            if (thief.dedicated) {
+                return false;
+            }
             for (auto& victim_ptr : procs) {
                 auto& victim = *victim_ptr;
-                if (&victim == &thief) continue;
+                if (&victim == &thief || victim.dedicated) continue;
 
                 Microthread* stolen = nullptr;
                 {
-                    std::lock_guard<std::mutex> lk(victim.run_mu);
+                    std::lock_guard<Mutex> lk(victim.run_mu);
 
                     // Try to acquire global_mu without blocking to avoid
                     // deadlock (take_from_global holds global_mu then
@@ -199,20 +642,18 @@ namespace csp {
 
                     if (!victim.busy) continue;
 
-                    auto* candidate = victim.busy->prev_;
-                    if (!candidate || candidate == &victim.main
-                        || candidate == victim.busy
-                        || candidate == victim.running) {
-                        continue;
-                    }
+                    // Never the head (next to run) or the running MT.
+                    run_queue q(victim.busy, &victim.main,
+                                victim.busy, victim.running);
+                    if (q.empty()) continue;
+                    auto* candidate = policy->steal(q).get();
+                    if (!candidate) continue;
+                    policy->notify(run_queue_event::steal, task(candidate));
 
                     // Delink from victim's DLL and push to global
                     // atomically (both locks held) so schedule() cannot
                     // see the MT with next_==null / in_global_==false.
-                    candidate->prev_->next_ = candidate->next_;
-                    candidate->next_->prev_ = candidate->prev_;
-                    candidate->next_ = nullptr;
-                    candidate->prev_ = nullptr;
+                    victim.unlink(candidate);
                     push_to_global(candidate);
                     stolen = candidate;
                 }
@@ -226,36 +667,90 @@ namespace csp {
 
         std::optional<std::chrono::steady_clock::time_point>
         Runtime::next_timer_deadline(Processor& p) {
-            if (p.timer_heap.empty()) {
+            std::lock_guard<Mutex> lk(p.timer_mu);
+            if (p.timers.empty()) {
                 return std::nullopt;
             }
-            return p.timer_heap.top().deadline;
+            // Exact, so a cascade doesn't cost a wakeup of its own.
+            return real_time(p.timers.due_ns());
         }
 
-        bool Runtime::has_work(Processor& p) {
-            {
-                std::lock_guard<std::mutex> lk(p.run_mu);
-                // Queue has real work if there's more than just the sentinel.
-                if (p.busy && p.busy->next_ != p.busy) {
-                    return true;
-                }
+        Microthread* Runtime::pick(Processor& p, Microthread* from) {
+            run_queue q(from, &p.main, g_self);
+            if (q.empty()) {
+                return from;
             }
+            auto t = policy->pop(q);
+            return t ? t.get() : from;
+        }
 
-            {
-                std::lock_guard<std::mutex> lk(global_mu);
-                if (!global_run_queue.empty()) {
-                    return true;
-                }
+        void Processor::push(Microthread* mt) {
+            if (!rt) {
+                link(mt);
+                return;
+            }
+            // Run-next goes right after the head rather than replacing
+            // it: the head may be the microthread that is running, which
+            // busy is what keeps steal_work away from.
+            task t(mt);
+            if (busy && rt->policy->push(t)) {
+                link_after(busy, mt);
+            } else {
+                link(mt);
             }
+            rt->policy->notify(run_queue_event::push, t);
+        }
 
-            if (!p.timer_heap.empty() &&
-                p.timer_heap.top().deadline <= std::chrono::steady_clock::now()) {
-                return true;
+        void Runtime::note_dispatch(Processor& p, Microthread* mt) {
+            if (mt != &p.main) {
+                policy->notify(run_queue_event::dispatch, task(mt));
+            }
+            if (mt->deadline_ns_ == Microthread::no_deadline) {
+                return;
             }
+            p.deadline_dispatches.fetch_add(1, std::memory_order_relaxed);
+            if (mt->deadline_ns_ < p.round_ns) {
+                p.deadline_misses.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
 
-            return false;
+        bool Runtime::has_work(Processor& p) {
+            // Runs as the park predicate on every wake, so only load the
+            // lock-free summaries; never take run_mu or global_mu here.
+            return p.queued.load(std::memory_order_acquire) > 0
+                || (!p.dedicated && global_len.load(std::memory_order_acquire) > 0)
+                || p.next_timer_ns.load(std::memory_order_acquire) <= now_ns();
         }
 
     }
 
+    runtime_stats get_runtime_stats() {
+        runtime_stats stats;
+        auto add = [&](detail::Runtime const & rt) {
+            for (auto& p : rt.procs) {
+                stats.deadline_dispatches += p->deadline_dispatches.load(std::memory_order_relaxed);
+                stats.deadline_misses += p->deadline_misses.load(std::memory_order_relaxed);
+                stats.colocated_wakeups += p->colocated_wakeups.load(std::memory_order_relaxed);
+                stats.remote_timer_fires += p->remote_timer_fires.load(std::memory_order_relaxed);
+                stats.timer_wakeups += p->timer_wakeups.load(std::memory_order_relaxed);
+                for (int i = 0; i < runtime_stats::timer_lateness_buckets; ++i) {
+                    stats.timer_lateness[i] += p->timer_lateness[i].load(std::memory_order_relaxed);
+                }
+            }
+        };
+        auto add_wait = [&](detail::Runtime & rt) {
+            std::lock_guard<std::mutex> lk(rt.global_mu);
+            stats.max_global_wait_ns = std::max(stats.max_global_wait_ns,
+                                                (uint64_t)rt.max_global_wait_ns);
+        };
+        add(detail::Runtime::instance());
+        add_wait(detail::Runtime::instance());
+        std::lock_guard<std::mutex> lk(detail::g_pools_mu);
+        for (auto& kv : detail::g_pools) {
+            add(*kv.second);
+            add_wait(*kv.second);
+        }
+        return stats;
+    }
+
 }
@@ -0,0 +1,63 @@
+#include <csp/internal/runtime.h>
+
+namespace csp {
+
+    using detail::Microthread;
+
+    size_t task::id() const {
+        return mt_->id_;
+    }
+
+    int64_t task::deadline_ns() const {
+        return mt_->deadline_ns_;
+    }
+
+    run_queue::iterator & run_queue::iterator::operator++() {
+        do {
+            mt_ = mt_->next_;
+        } while (mt_ != q_->first_ && q_->skipped(mt_));
+        if (mt_ == q_->first_) {
+            mt_ = nullptr;
+        }
+        return *this;
+    }
+
+    run_queue::iterator run_queue::begin() const {
+        iterator i(this, first_);
+        if (skipped(first_)) {
+            ++i;
+        }
+        return i;
+    }
+
+    task run_queue::back() const {
+        auto mt = first_;
+        do {
+            mt = mt->prev_;
+            if (!skipped(mt)) {
+                return task(mt);
+            }
+        } while (mt != first_);
+        return task();
+    }
+
+    task edf_policy::most_urgent(run_queue const & q) {
+        task best;
+        for (auto t : q) {
+            if (t.deadline_ns() != Microthread::no_deadline &&
+                (!best || t.deadline_ns() < best.deadline_ns())) {
+                best = t;
+            }
+        }
+        return best;
+    }
+
+    std::shared_ptr<run_queue_policy> make_queue_policy(sched_policy p) {
+        switch (p) {
+        case sched_policy::edf: return std::make_shared<edf_policy>();
+        case sched_policy::lifo: return std::make_shared<lifo_policy>();
+        default: return std::make_shared<fifo_policy>();
+        }
+    }
+
+}
@@ -0,0 +1,82 @@
+#include <csp/timer.h>
+#include <csp/internal/runtime.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace csp {
+
+    namespace detail {
+
+        // A shared_tick producer.  New subscribers wait in `joining` until
+        // the producer adopts them between ticks; it sends outside
+        // ticker_mu, since a send may switch straight to the reader.
+        struct SharedTicker {
+            std::vector<writer<clock::time_point>> joining;   // Under Runtime::ticker_mu
+        };
+
+        static void run_ticker(Runtime & rt, clock::duration interval,
+                               std::shared_ptr<SharedTicker> self) {
+            std::vector<writer<clock::time_point>> subscribers;
+            auto next = clock::now() + interval;
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lk(rt.ticker_mu);
+                    for (auto & w : self->joining) {
+                        subscribers.push_back(std::move(w));
+                    }
+                    self->joining.clear();
+                    if (subscribers.empty()) {
+                        auto i = rt.tickers.find(interval.count());
+                        if (i != rt.tickers.end() && i->second == self) {
+                            rt.tickers.erase(i);
+                        }
+                        return;
+                    }
+                }
+
+                sleep_until(next);
+                auto now = clock::now();
+
+                // Deliver to whoever is waiting and forget the dead.
+                subscribers.erase(
+                    std::remove_if(subscribers.begin(), subscribers.end(),
+                                   [&](auto const & w) { return (w << now).try_run() < 0; }),
+                    subscribers.end());
+
+                // Skip ticks missed while overloaded rather than burst.
+                next += interval;
+                if (next <= now) {
+                    next += (now - next) / interval * interval + interval;
+                }
+            }
+        }
+
+    }
+
+    reader<clock::time_point> shared_tick(clock::duration interval) {
+        // Inside csp_blocking the caller sits on a limbo processor, which
+        // has no runtime: its ticker belongs to its home pool.
+        auto & p = detail::current_p();
+        auto & rt = p.rt ? *p.rt : *detail::g_self->rt_;
+        reader<clock::time_point> r;
+        std::shared_ptr<detail::SharedTicker> start;
+        {
+            std::lock_guard<std::mutex> lk(rt.ticker_mu);
+            auto & t = rt.tickers[interval.count()];
+            if (!t) {
+                start = t = std::make_shared<detail::SharedTicker>();
+            }
+            t->joining.push_back(++r);
+        }
+        if (start) {
+            spawn_on(reinterpret_cast<pool>(&rt), [&rt, interval, start] {
+                detail::run_ticker(rt, interval, start);
+            });
+        }
+        return r;
+    }
+
+}
@@ -0,0 +1,30 @@
+#include "testutil.h"
+
+#include <cstdlib>
+#include <new>
+
+// Replacing operator new reaches the whole test binary, so it lives in
+// its own translation unit and counts only while an AllocCounter is alive
+// on the allocating thread.
+
+namespace {
+
+    thread_local long * t_allocs = nullptr;
+
+}
+
+AllocCounter::AllocCounter() : prev_(t_allocs) { t_allocs = &count_; }
+AllocCounter::~AllocCounter() { t_allocs = prev_; }
+
+void * operator new(size_t n) {
+    if (t_allocs) {
+        ++*t_allocs;
+    }
+    if (void * p = std::malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete(void * p, size_t) noexcept { std::free(p); }
@@ -5,7 +5,10 @@
 #include <csp/tee.h>
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <numeric>
+#include <string>
 #include <vector>
 
 using namespace csp;
@@ -187,6 +190,166 @@ TEST_CASE("Channel - ReaderGone") {
     CHECK_EQ(1023, total);
 }
 
+TEST_CASE("Channel - Handoff") {
+    RunStats stats;
+
+    // One writer and one reader meet without the channel's lock; peers
+    // that show up later (an alt, another endpoint copy, the writer's
+    // death) must still find whoever is parked there.
+    channel<int> ch, other;
+    auto w = +ch;
+
+    std::vector<int> got;
+    bool dead = false;
+    stats.spawn([r = -ch, &got, &dead]{
+        int n;
+        while (r >> n) {
+            got.push_back(n);
+        }
+        dead = true;
+    });
+    ch.release();
+    csp::schedule();
+    CHECK(got.empty());
+
+    stats.spawn([w = std::move(w), in = -other]{
+        for (int n = 1; n <= 100; ++n) {
+            w << n;
+        }
+        // The reader is parked; an alt takes the locked path.
+        int n;
+        CHECK_EQ(1, prialt(w << 101, in >> n));
+        auto w2 = w;
+        w2 << 102;
+    });
+    csp::schedule();
+    REQUIRE_EQ(102u, got.size());
+    CHECK_EQ(102 * 103 / 2, std::accumulate(got.begin(), got.end(), 0));
+    CHECK(dead);
+}
+
+TEST_CASE("Channel - Buffered") {
+    RunStats stats;
+
+    channel<int> ch(4);
+
+    int sent = 0;
+    std::vector<int> got;
+
+    // The writer fills the buffer without a reader, then blocks.
+    stats.spawn([out = +ch, &sent]{
+        for (int n = 1; n <= 10; ++n) {
+            REQUIRE(bool(out << n));
+            ++sent;
+        }
+    });
+    while (csp_run()) { }
+    CHECK_EQ(4, sent);
+
+    // Each read frees a slot for the blocked writer.
+    stats.spawn([in = -ch, &got]{
+        for (int n; in >> n;) {
+            got.push_back(n);
+        }
+    });
+    ch.release();
+    csp::schedule();
+
+    CHECK_EQ(10, sent);
+    CHECK_EQ((std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), got);
+}
+
+TEST_CASE("Channel - BufferedWriterGone") {
+    RunStats stats;
+
+    // Messages held when the writer dies are still delivered, then the
+    // reader sees the death; messages nobody reads die with the channel.
+    auto msg = std::make_shared<int>(0);
+    channel<std::shared_ptr<int>> ch(8);
+    {
+        auto w = +ch;
+        stats.spawn([w, msg]{
+            for (int i = 0; i < 3; ++i) {
+                w << msg;
+            }
+        });
+    }
+    auto r = -ch;
+    ch.release();
+    while (csp_run()) { }
+    CHECK_EQ(4, msg.use_count());
+
+    int got = 0;
+    stats.spawn([r, &got]{
+        std::shared_ptr<int> p;
+        CHECK_EQ(1, prialt(r >> p));
+        ++got;
+        CHECK_EQ(1, prialt(r >> p));
+        ++got;
+    });
+    while (csp_run()) { }
+    CHECK_EQ(2, got);
+    CHECK_EQ(2, msg.use_count());
+
+    // Drop the last reader with one message still held.
+    r = {};
+    CHECK_EQ(1, msg.use_count());
+}
+
+TEST_CASE("Channel - BufferedReaderGone") {
+    RunStats stats;
+
+    channel<int> ch(2);
+
+    int total = 0;
+    bool failed = false;
+
+    stats.spawn([out = +ch, &failed]{
+        for (int n = 1; ; n *= 2) {
+            if (!(out << n)) {
+                failed = true;
+                return;
+            }
+        }
+    });
+    stats.spawn([in = -ch, &total]{
+        for (int i = 0; i < 10; ++i) {
+            total += in.read();
+        }
+    });
+
+    ch.release();
+
+    csp::schedule();
+
+    CHECK_EQ(1023, total);
+    CHECK(failed);
+}
+
+TEST_CASE("Channel - BufferedAlt") {
+    RunStats stats;
+
+    channel<int> a, b(1);
+    auto ra = -a, rb = -b;
+    auto wb = +b;
+    int n = -1;
+
+    // Room in the buffer makes a write ready; a held message makes a
+    // read ready, even ahead of an unbuffered channel with no writer.
+    CHECK_EQ(1, (wb << 7).try_run());
+    CHECK_EQ(0, (wb << 8).try_run());
+    CHECK_EQ(2, prialt(ra >> n, rb >> n));
+    CHECK_EQ(7, n);
+    CHECK_EQ(-3, prialt(ra >> n, rb >> n, ~skip));
+
+    a.release();
+    b.release();
+    ra = {};
+    rb = {};
+    wb = {};
+    while (csp_run()) { }
+}
+
 TEST_CASE("Channel - NWriters") {
     RunStats stats;
 
@@ -429,6 +592,227 @@ TEST_CASE("Channel - ActionBig") {
     CHECK_EQ(big2.d, big3.d);
 }
 
+TEST_CASE("Channel - ActionInline") {
+    RunStats stats;
+
+    // Inline messages survive the action moving, here through vector
+    // growth; tunneled ones keep every bit; oversized ones still work.
+    struct Huge {
+        char s[100];
+    };
+    channel<std::string> chs;
+    channel<int64_t> chi;
+    channel<double> chd;
+    channel<Huge> chh;
+
+    Huge huge = {};
+    std::strcpy(huge.s, "a message too big to hold inline");
+    std::vector<action> actions;
+    actions.push_back(+chs << std::string("a string held inline, not in SSO"));
+    actions.push_back(+chi << INT64_MIN);
+    actions.push_back(+chd << -0.5);
+    actions.push_back(+chh << huge);
+
+    std::string s;
+    int64_t i = 0;
+    double d = 0;
+    Huge h = {};
+    stats.spawn([&]{
+        -chs >> s;
+        -chi >> i;
+        -chd >> d;
+        -chh >> h;
+    });
+
+    for (int k = 0; k < 4; ++k) {
+        CHECK_GT(csp::prialt(actions), 0);
+        actions.erase(actions.begin());
+    }
+    CHECK_EQ("a string held inline, not in SSO", s);
+    CHECK_EQ(INT64_MIN, i);
+    CHECK_EQ(-0.5, d);
+    CHECK_EQ(std::string(huge.s), h.s);
+}
+
+TEST_CASE("Channel - SendsDontAllocate") {
+    RunStats stats;
+
+    channel<int> chi;
+    channel<std::string> chs;
+    long allocs = -1;
+
+    stats.spawn([wi = +chi, ws = +chs, &allocs]{
+        wi << 0;
+        AllocCounter counter;
+        for (int n = 1; n <= 100; ++n) {
+            wi << n;
+            ws << std::string("short");
+        }
+        allocs = counter.count();
+    });
+    stats.spawn([ri = -chi, rs = -chs]{
+        int n;
+        std::string s;
+        ri >> n;
+        for (int k = 0; k < 100; ++k) {
+            ri >> n;
+            rs >> s;
+        }
+    });
+
+    chi.release();
+    chs.release();
+    csp::schedule();
+
+    CHECK_EQ(0, allocs);
+}
+
+TEST_CASE("Channel - AltsDontAllocate") {
+    RunStats stats;
+
+    constexpr int CHANS = 4;
+    std::vector<channel<int>> chans(CHANS);
+    long allocs = -1;
+
+    for (auto & ch : chans) {
+        stats.spawn([w = +ch]{ for (int i = 0; w << i; ++i) { } });
+    }
+    stats.spawn([r0 = -chans[0], r1 = -chans[1], r2 = -chans[2], r3 = -chans[3], &allocs]{
+        int n;
+        alt(r0 >> n, r1 >> n, r2 >> n, r3 >> n);
+        AllocCounter counter;
+        for (int k = 0; k < 100; ++k) {
+            alt(r0 >> n, r1 >> n);
+            prialt(r0 >> n, r1 >> n, r2 >> n);
+            alt(r0 >> n, r1 >> n, r2 >> n, r3 >> n);
+            action actions[] = {r3 >> n, r2 >> n, r1 >> n};
+            prialt(actions, 2 + k % 2);
+        }
+        allocs = counter.count();
+    });
+
+    for (auto & ch : chans) {
+        ch.release();
+    }
+    csp::schedule();
+
+    CHECK_EQ(0, allocs);
+}
+
+TEST_CASE("Channel - SelectSet") {
+    RunStats stats;
+
+    // Registrations outlive each wait: messages sent while the owner is
+    // busy elsewhere are still found, dead channels keep reporting until
+    // removed, and removed ones no longer fire.
+    constexpr int CHANS = 5;
+    std::vector<channel<int>> chans(CHANS);
+    channel<int> out;
+    std::vector<int> got;
+    int dead = 0;
+
+    std::vector<reader<int>> rs;
+    for (auto & ch : chans) {
+        rs.push_back(-ch);
+    }
+    stats.spawn([&, rs, o = +out]{
+        std::vector<int> ns(CHANS);
+        int next = 100;
+        select_set set;
+        std::vector<int> ids;
+        for (int c = 0; c < CHANS; ++c) {
+            ids.push_back(set.add(rs[c] >> ns[c]));
+        }
+        CHECK_EQ(0, set.try_wait());
+        int out_id = set.add(o << next);
+        for (int live = CHANS; live;) {
+            int id = set.wait();
+            if (id == out_id) {
+                continue;
+            }
+            int c = int(std::find(ids.begin(), ids.end(), std::abs(id)) - ids.begin());
+            REQUIRE(c < CHANS);
+            if (id > 0) {
+                got.push_back(ns[c]);
+            } else {
+                ++dead;
+                --live;
+                set.remove(-id);
+            }
+        }
+    });
+
+    for (int c = 0; c < CHANS; ++c) {
+        stats.spawn([c, w = +chans[c]]{
+            for (int i = 0; i < 3; ++i) {
+                w << c * 10 + i;
+            }
+        });
+    }
+    int sent = 0;
+    stats.spawn([&sent, r = -out]{
+        r >> sent;
+    });
+    chans.clear();
+    out.release();
+
+    csp::schedule();
+
+    std::sort(got.begin(), got.end());
+    CHECK_EQ((std::vector<int>{0, 1, 2, 10, 11, 12, 20, 21, 22, 30, 31, 32, 40, 41, 42}), got);
+    CHECK_EQ(CHANS, dead);
+    CHECK_EQ(100, sent);
+}
+
+TEST_CASE("Channel - SelectSetWrites") {
+    RunStats stats;
+
+    // A write leaves the set once it sends, so the next message is the
+    // one added next, not a moved-from copy of the first.
+    channel<std::string> ch;
+    std::vector<std::string> got;
+
+    stats.spawn([w = +ch]{
+        select_set set;
+        std::string const words[] = {"a string too long for SSO, first", "and again, second"};
+        for (auto & word : words) {
+            int id = set.add(w << word);
+            CHECK_EQ(id, set.wait());
+            CHECK_EQ(0, set.try_wait());
+        }
+    });
+    stats.spawn([&got, r = -ch]{
+        for (std::string s; r >> s;) {
+            got.push_back(s);
+        }
+    });
+    ch.release();
+
+    csp::schedule();
+
+    CHECK_EQ((std::vector<std::string>{"a string too long for SSO, first", "and again, second"}), got);
+}
+
+TEST_CASE("Channel - SelectSetOutlivesEndpoints") {
+    RunStats stats;
+
+    // A registered chanop keeps its channel alive once the caller drops
+    // its own endpoints, until the set removes it or goes away.
+    stats.spawn([]{
+        int n = 0;
+        select_set set;
+        channel<int> a, b;
+        int id = set.add(-a >> n);
+        set.add(-b >> n);
+        a.release();
+        b.release();
+        CHECK_EQ(-id, set.wait());
+        set.remove(id);
+    });
+
+    csp::schedule();
+}
+
 TEST_CASE("Channel - String") {
     RunStats stats;
 
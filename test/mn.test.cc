@@ -4,14 +4,20 @@
 #include <doctest/doctest.h>
 
 #include <csp/microthread.h>
+#include <csp/scheduler.h>
 #include <csp/timer.h>
 
 #include <atomic>
+#include <filesystem>
 #include <mutex>
 #include <set>
+#include <string>
 #include <thread>
 #include <vector>
 
+// A CSP_SINGLE_THREADED build has no M:N mode to test.
+#if !CSP_SINGLE_THREADED
+
 TEST_CASE("MN - MultipleThreads") {
     csp::init_runtime(4);
 
@@ -230,6 +236,704 @@ TEST_CASE("MN - StressChannels") {
     csp::shutdown_runtime();
 }
 
+TEST_CASE("MN - BufferedChannels") {
+    csp::init_runtime(4);
+
+    // Several writers and readers share each buffered channel, so holds,
+    // takes and refills from blocked writers race across processors.
+    constexpr int CHANS = 8, WRITERS = 3, READERS = 2, MSGS = 500;
+    std::atomic<long> total{0};
+    std::atomic<int> received{0};
+
+    for (int c = 0; c < CHANS; ++c) {
+        csp::channel<std::string> ch(c % 4 + 1);
+        for (int k = 0; k < WRITERS; ++k) {
+            csp::spawn([w = +ch] {
+                for (int i = 0; i < MSGS; ++i) {
+                    w << std::to_string(i);
+                }
+            });
+        }
+        for (int k = 0; k < READERS; ++k) {
+            csp::spawn([r = -ch, &total, &received] {
+                for (std::string s; r >> s;) {
+                    total.fetch_add(std::stol(s), std::memory_order_relaxed);
+                    received.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    csp::schedule();
+
+    CHECK_EQ(CHANS * WRITERS * MSGS, received.load());
+    CHECK_EQ(long(CHANS) * WRITERS * (MSGS * (MSGS - 1) / 2), total.load());
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - AltManyWriters") {
+    csp::init_runtime(4);
+
+    // Readers alt over eight channels, half buffered, while writers on
+    // other processors come and go, so the lock-free scan races with
+    // registrations, handoffs and endpoint deaths.
+    constexpr int CHANS = 8, READERS = 2, MSGS = 500;
+    std::vector<csp::channel<int>> chans;
+    for (int c = 0; c < CHANS; ++c) {
+        chans.push_back(c % 2 ? csp::channel<int>(4) : csp::channel<int>());
+    }
+    std::atomic<long> total{0};
+
+    for (auto & ch : chans) {
+        csp::spawn([w = +ch] {
+            for (int i = 0; i < MSGS; ++i) {
+                w << i;
+            }
+        });
+    }
+    for (int k = 0; k < READERS; ++k) {
+        std::vector<csp::reader<int>> rs;
+        for (auto & ch : chans) {
+            rs.push_back(-ch);
+        }
+        csp::spawn([rs, &total]() mutable {
+            std::vector<int> ns(rs.size());
+            while (!rs.empty()) {
+                std::vector<csp::action> actions;
+                for (size_t i = 0; i < rs.size(); ++i) {
+                    actions.push_back(rs[i] >> ns[i]);
+                }
+                int which = csp::alt(actions);
+                if (which > 0) {
+                    total.fetch_add(ns[which - 1], std::memory_order_relaxed);
+                } else {
+                    rs.erase(rs.begin() + (-which - 1));
+                }
+            }
+        });
+    }
+    chans.clear();
+
+    csp::schedule();
+
+    CHECK_EQ(long(CHANS) * (MSGS * (MSGS - 1) / 2), total.load());
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - SelectSet") {
+    csp::init_runtime(4);
+
+    // Writers on other processors race the owner between its waits, so
+    // entries are claimed while it sleeps and queued while it works.
+    constexpr int CHANS = 32, MSGS = 200;
+    std::vector<csp::reader<int>> rs;
+    for (int c = 0; c < CHANS; ++c) {
+        csp::channel<int> ch = c % 4 ? csp::channel<int>() : csp::channel<int>(4);
+        csp::spawn([w = +ch] {
+            for (int i = 0; i < MSGS; ++i) {
+                w << i;
+            }
+        });
+        rs.push_back(-ch);
+    }
+    long total = 0;
+    int dead = 0;
+
+    csp::spawn([rs, &total, &dead] {
+        std::vector<int> ns(CHANS);
+        csp::select_set set;
+        for (int c = 0; c < CHANS; ++c) {
+            CHECK_EQ(c + 1, set.add(rs[c] >> ns[c]));
+        }
+        for (int live = CHANS; live;) {
+            int id = set.wait();
+            if (id > 0) {
+                total += ns[id - 1];
+            } else {
+                set.remove(-id);
+                ++dead;
+                --live;
+            }
+        }
+    });
+    rs.clear();
+
+    csp::schedule();
+
+    CHECK_EQ(long(CHANS) * (MSGS * (MSGS - 1) / 2), total);
+    CHECK_EQ(CHANS, dead);
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - BlockingOffload") {
+    using namespace std::chrono_literals;
+
+    // One worker: if the blocking call kept its processor, nothing else
+    // could run until it returned.
+    csp::init_runtime(2);
+
+    std::atomic<bool> released{false};
+    std::atomic<bool> ran_while_blocked{false};
+
+    csp::spawn([&] {
+        csp::blocking([&] {
+            auto give_up = std::chrono::steady_clock::now() + 2s;
+            while (!released.load() && std::chrono::steady_clock::now() < give_up) {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+    });
+
+    csp::spawn([&] {
+        csp::channel<int> ch;
+        csp::spawn([w = ++ch] {
+            for (int i = 0; i < 100; ++i) w << i;
+        });
+        auto r = --ch;
+        int sum = 0;
+        for (int v; r >> v;) sum += v;
+        CHECK_EQ(4950, sum);
+        ran_while_blocked.store(!released.load());
+        released.store(true);
+    });
+
+    csp::schedule();
+
+    CHECK(ran_while_blocked.load());
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - BlockingResult") {
+    csp::init_runtime(3);
+
+    constexpr int N = 20;
+    std::atomic<int> total{0};
+    std::atomic<int> caught{0};
+
+    for (int i = 0; i < N; ++i) {
+        csp::spawn([&, i] {
+            total.fetch_add(csp::blocking([i] { return i; }));
+            try {
+                csp::blocking([] { throw std::runtime_error("boom"); });
+            } catch (std::runtime_error const &) {
+                caught.fetch_add(1);
+            }
+            // Still a working microthread after rejoining the runtime.
+            csp_yield();
+        });
+    }
+
+    csp::schedule();
+
+    CHECK_EQ(N * (N - 1) / 2, total.load());
+    CHECK_EQ(N, caught.load());
+
+    csp::shutdown_runtime();
+}
+
+#ifdef __linux__
+TEST_CASE("MN - BlockingSparesQuit") {
+    using namespace std::chrono_literals;
+
+    auto os_threads = [] {
+        std::filesystem::directory_iterator tasks("/proc/self/task");
+        return std::distance(begin(tasks), end(tasks));
+    };
+
+    csp::init_runtime(2);
+    auto before = os_threads();
+
+    // Calls held open together need a spare thread each.  Once they
+    // return, no more than one idle spare per processor stays.
+    constexpr int N = 16;
+    std::atomic<int> blocked{0};
+    for (int i = 0; i < N; ++i) {
+        csp::spawn([&] {
+            csp::blocking([&] {
+                blocked.fetch_add(1);
+                auto give_up = std::chrono::steady_clock::now() + 2s;
+                while (blocked.load() < N && std::chrono::steady_clock::now() < give_up) {
+                    std::this_thread::sleep_for(1ms);
+                }
+            });
+        });
+    }
+    csp::schedule();
+    CHECK_EQ(N, blocked.load());
+
+    // Spares quit once back on their native stacks, which may lag.
+    auto give_up = std::chrono::steady_clock::now() + 2s;
+    while (os_threads() > before + 2 && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::sleep_for(1ms);
+    }
+    CHECK_LE(os_threads(), before + 2);
+
+    csp::shutdown_runtime();
+}
+#endif
+
+TEST_CASE("MN - EarliestDeadlineFirst") {
+    using namespace std::chrono_literals;
+
+    csp::runtime_options opts;
+    opts.num_procs = 2;
+    opts.policy = csp::sched_policy::edf;
+    csp::init_runtime(opts);
+
+    std::mutex mu;
+    std::string trace;
+    auto now = csp::clock::now();
+    auto wake = now + 20ms;
+
+    for (int i = 0; i < 8; ++i) {
+        csp::spawn([&, i] {
+            // Later spawns get earlier deadlines.
+            csp::set_deadline(now + (100 - 10 * i) * 1ms);
+            csp::sleep_until(wake);
+            std::lock_guard<std::mutex> lk(mu);
+            trace += char('0' + i);
+        });
+    }
+
+    csp::schedule();
+
+    CHECK_EQ(std::string("76543210"), trace);
+    CHECK_EQ(0, csp::get_runtime_stats().deadline_misses);
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - DeadlineSleeper") {
+    using namespace std::chrono_literals;
+
+    csp::runtime_options opts;
+    opts.num_procs = 2;
+    opts.policy = csp::sched_policy::edf;
+    csp::init_runtime(opts);
+
+    // As Thread - DeadlineSleeper, on a worker: its timers must fire
+    // even though EDF never runs out of yielding spinners.
+    auto start = csp::clock::now();
+    auto give_up = start + 5s;
+    std::atomic<bool> stop{false};
+    std::atomic<int64_t> took_ms{-1};
+    csp::spawn([&] {
+        csp::set_deadline(start + 2ms);
+        csp::sleep(1ms);
+        took_ms = std::chrono::duration_cast<std::chrono::milliseconds>(csp::clock::now() - start).count();
+        stop = true;
+    });
+    for (int i = 0; i < 2; ++i) {
+        csp::spawn([&] {
+            csp::set_deadline(start + 1s);
+            while (!stop.load() && csp::clock::now() < give_up) {
+                csp_yield();
+            }
+        });
+    }
+    csp::schedule();
+
+    CHECK_GE(took_ms.load(), 0);
+    CHECK_LT(took_ms.load(), 1000);
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - PoolRegistry") {
+    CHECK_THROWS_AS(csp::create_pool("early"), csp::microthread_error);
+
+    csp::init_runtime(2);
+
+    auto io = csp::create_pool("io", 1);
+    REQUIRE(io);
+    CHECK_EQ(io, csp::find_pool("io"));
+    CHECK_EQ(nullptr, csp::find_pool("compute"));
+    CHECK_THROWS_AS(csp::create_pool("io", 1), csp::microthread_error);
+
+    csp::shutdown_runtime();
+    CHECK_EQ(nullptr, csp_pool_find("io"));
+}
+
+TEST_CASE("MN - PoolCrossWakeup") {
+    csp::init_runtime(2);
+    auto pool = csp::create_pool("other", 2);
+
+    csp::channel<int> ping, pong;
+    std::atomic<std::thread::id> pool_tid{}, main_tid{};
+    constexpr int N = 1000;
+
+    csp::spawn_on(pool, [&, r = --ping, w = ++pong] {
+        pool_tid.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        for (int v; r >> v;) {
+            w << (v + 1);
+        }
+    });
+
+    csp::spawn([&, w = ++ping, r = --pong] {
+        main_tid.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        int sum = 0;
+        for (int i = 0; i < N; ++i) {
+            w << i;
+            int v = 0;
+            REQUIRE(bool(r >> v));
+            sum += v;
+        }
+        CHECK_EQ(N * (N + 1) / 2, sum);
+    });
+
+    csp::schedule();
+    bool distinct = pool_tid.load() != main_tid.load();
+    CHECK(distinct);
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - PoolIsolation") {
+    using namespace std::chrono_literals;
+
+    // One default worker; a compute burst that never yields would starve
+    // it if both ran on the same runtime.
+    csp::init_runtime(2);
+    auto compute = csp::create_pool("compute", 1);
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> starved{false};
+
+    csp::spawn_on(compute, [&] {
+        auto give_up = std::chrono::steady_clock::now() + 5s;
+        while (!done.load(std::memory_order_acquire)) {
+            if (std::chrono::steady_clock::now() > give_up) {
+                starved = true;
+                break;
+            }
+        }
+    });
+
+    csp::channel<int> ch;
+    csp::spawn([&, w = ++ch] {
+        for (int i = 0; i < 100; ++i) {
+            w << i;
+        }
+    });
+    csp::spawn([&, r = --ch] {
+        int n = 0;
+        for (int v; r >> v;) {
+            ++n;
+        }
+        CHECK_EQ(100, n);
+        done.store(true, std::memory_order_release);
+    });
+
+    csp::schedule();
+    CHECK_FALSE(starved.load());
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - PoolSharedTick") {
+    using namespace std::chrono_literals;
+
+    // The default runtime's only worker spins, so a pool's ticks can only
+    // come from a producer running in the pool.
+    csp::init_runtime(2);
+    auto timers = csp::create_pool("timers", 1);
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> starved{false};
+
+    csp::spawn([&] {
+        auto give_up = std::chrono::steady_clock::now() + 5s;
+        while (!done.load(std::memory_order_acquire)) {
+            if (std::chrono::steady_clock::now() > give_up) {
+                starved = true;
+                break;
+            }
+        }
+    });
+    csp::spawn_on(timers, [&] {
+        auto ticker = csp::shared_tick(1ms);
+        for (int k = 0; k < 3; ++k) {
+            ticker.read();
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    csp::schedule();
+    CHECK_FALSE(starved.load());
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - ChannelAffinity") {
+    csp::init_runtime(4);
+
+    // A chatty pair should end up woken onto one processor instead of
+    // bouncing through the global queue.
+    csp::channel<int> ping, pong;
+    constexpr int N = 20000;
+
+    csp::spawn([r = --ping, w = ++pong] {
+        for (int v; r >> v;) {
+            w << v;
+        }
+    });
+
+    csp::spawn([w = ++ping, r = --pong] {
+        long sum = 0;
+        for (int i = 0; i < N; ++i) {
+            w << i;
+            int v = 0;
+            REQUIRE(bool(r >> v));
+            sum += v;
+        }
+        CHECK_EQ(long(N) * (N - 1) / 2, sum);
+    });
+
+    csp::schedule();
+    CHECK_GT(csp::get_runtime_stats().colocated_wakeups, 0);
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - GlobalQueueFairness") {
+    using namespace std::chrono_literals;
+
+    // One worker.  A yield loop keeps its local queue non-empty forever,
+    // so only the fairness tick lets the global queue in.
+    csp::init_runtime(2);
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> starved{false};
+
+    csp::spawn([&] {
+        auto give_up = std::chrono::steady_clock::now() + 5s;
+        for (int i = 0; !stop.load(std::memory_order_acquire); ++i) {
+            if (i == 1000) {
+                csp::spawn([&] { stop.store(true, std::memory_order_release); });
+            }
+            if (std::chrono::steady_clock::now() > give_up) {
+                starved = true;
+                break;
+            }
+            csp_yield();
+        }
+    });
+
+    csp::schedule();
+    CHECK_FALSE(starved.load());
+    CHECK_GT(csp::get_runtime_stats().max_global_wait_ns, 0);
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - SpawnPlacement") {
+    // Placement picks the initial queue only; stealing may still move a
+    // microthread, so the explicit and spread cases only check that every
+    // placed spawn runs.
+    csp::init_runtime(3);
+
+    // P0 is the main thread; 3 is out of range.
+    CHECK_THROWS_AS(csp::spawn(csp::on_processor(0), [] { }), csp::microthread_error);
+    CHECK_THROWS_AS(csp::spawn(csp::on_processor(3), [] { }), csp::microthread_error);
+
+    std::atomic<int> ran{0};
+    csp::spawn(csp::on_processor(1), [&] { ++ran; });
+    csp::spawn(csp::on_processor(2), [&] { ++ran; });
+    for (int i = 0; i < 8; ++i) {
+        csp::spawn(csp::placement::spread, [&] { ++ran; });
+    }
+    csp::schedule();
+    CHECK_EQ(10, ran.load());
+
+    csp::shutdown_runtime();
+
+    // With a single worker nothing steals, so a local child runs next on
+    // the parent's worker as soon as the parent yields.
+    csp::init_runtime(2);
+
+    std::thread::id parent, child;
+    int order = 0, child_order = -1, parent_order = -1;
+    csp::spawn([&] {
+        parent = std::this_thread::get_id();
+        csp::spawn(csp::placement::local, [&] {
+            child = std::this_thread::get_id();
+            child_order = order++;
+        });
+        csp_yield();
+        parent_order = order++;
+    });
+    csp::schedule();
+
+    bool same = parent == child;
+    CHECK(same);
+    CHECK_EQ(0, child_order);
+    CHECK_EQ(1, parent_order);
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - DefaultPlacementChecked") {
+    // A bad runtime_options::spawn_placement fails each spawn, as the
+    // same placement passed explicitly would.
+    for (auto where : {csp::placement::dedicated, csp::on_processor(0), csp::on_processor(3)}) {
+        csp::runtime_options opts;
+        opts.num_procs = 3;
+        opts.spawn_placement = where;
+        csp::init_runtime(opts);
+        CHECK_THROWS_AS(csp::spawn([] { }), csp::microthread_error);
+        csp::shutdown_runtime();
+    }
+}
+
+TEST_CASE("MN - DedicatedProcessors") {
+    csp::init_runtime(3);
+    CHECK_THROWS_AS(csp::spawn(csp::placement::dedicated, [] { }), csp::microthread_error);
+    csp::shutdown_runtime();
+
+    csp::runtime_options opts;
+    opts.num_procs = 3;
+    opts.dedicated_procs = 2;   // Would leave no shared worker.
+    CHECK_THROWS_AS(csp::init_runtime(opts), csp::microthread_error);
+
+    opts.num_procs = 4;
+    opts.dedicated_procs = 1;   // P3
+    csp::init_runtime(opts);
+
+    constexpr int N = 200;
+    csp::channel<int> ticks;
+    std::set<std::thread::id> hot_ids, pinned_ids, bulk_ids;
+    std::mutex mu;
+    int received = 0;
+
+    // The latency-critical reader: channel waits, timer sleeps and
+    // yields must all bring it back to the same OS thread.
+    csp::spawn(csp::placement::dedicated, [&, r = --ticks] {
+        for (int v; r >> v;) {
+            hot_ids.insert(std::this_thread::get_id());
+            if (v % 50 == 0) {
+                csp::sleep(std::chrono::microseconds(100));
+            }
+            csp_yield();
+            ++received;
+        }
+    });
+    csp::spawn(csp::on_processor(3), [&] {
+        for (int i = 0; i < 20; ++i) {
+            pinned_ids.insert(std::this_thread::get_id());
+            csp_yield();
+        }
+    });
+
+    // Bulk work on the shared processors, including the producer.
+    csp::spawn([w = ++ticks] {
+        for (int i = 0; i < N; ++i) {
+            w << i;
+        }
+    });
+    for (int k = 0; k < 8; ++k) {
+        csp::spawn(csp::placement::spread, [&] {
+            for (int i = 0; i < 500; ++i) {
+                {
+                    std::lock_guard<std::mutex> lk(mu);
+                    bulk_ids.insert(std::this_thread::get_id());
+                }
+                csp_yield();
+            }
+        });
+    }
+
+    csp::schedule();
+
+    CHECK_EQ(N, received);
+    REQUIRE_EQ(1u, hot_ids.size());
+    bool same = pinned_ids == hot_ids;
+    CHECK(same);
+    bool isolated = bulk_ids.count(*hot_ids.begin()) == 0;
+    CHECK(isolated);
+
+    csp::shutdown_runtime();
+}
+
+namespace {
+
+    // Counts events and never lets another processor steal.
+    struct counting_policy : csp::fifo_policy {
+        std::atomic<int> pushes{0}, dispatches{0}, steals{0}, steal_asks{0};
+        csp::task steal(csp::run_queue const &) override {
+            ++steal_asks;
+            return csp::task();
+        }
+        void notify(csp::run_queue_event e, csp::task) override {
+            switch (e) {
+            case csp::run_queue_event::push: ++pushes; break;
+            case csp::run_queue_event::dispatch: ++dispatches; break;
+            case csp::run_queue_event::steal: ++steals; break;
+            }
+        }
+    };
+
+}
+
+TEST_CASE("MN - RunQueuePolicy") {
+    auto policy = std::make_shared<counting_policy>();
+    csp::runtime_options opts;
+    opts.num_procs = 4;
+    opts.queue_policy = policy;
+    csp::init_runtime(opts);
+
+    // Pile work onto P1 so the other workers would normally steal it.
+    std::atomic<int> done{0};
+    for (int k = 0; k < 16; ++k) {
+        csp::spawn(csp::on_processor(1), [&] {
+            for (int i = 0; i < 50; ++i) {
+                csp_yield();
+            }
+            ++done;
+        });
+    }
+    csp::schedule();
+
+    CHECK_EQ(16, done.load());
+    CHECK_GE(policy->pushes.load(), 16);
+    CHECK_GE(policy->dispatches.load(), 16);
+    CHECK_EQ(0, policy->steals.load());
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("MN - TimersFireWhileBusy") {
+    using namespace std::chrono_literals;
+
+    // No stealing, so the spinner keeps P1 busy and only another
+    // processor can fire the timer armed there.
+    csp::runtime_options opts;
+    opts.num_procs = 3;
+    opts.queue_policy = std::make_shared<counting_policy>();
+    csp::init_runtime(opts);
+
+    auto spin = CSP_TEST_SANITIZER ? 600ms : 300ms;
+    std::atomic<int64_t> slept_ns{0};
+    csp::spawn(csp::on_processor(1), [&] {
+        auto start = csp::clock::now();
+        csp::sleep(5ms);
+        slept_ns = (csp::clock::now() - start).count();
+    });
+    csp::spawn(csp::on_processor(1), [spin] {
+        auto end = csp::clock::now() + spin;
+        while (csp::clock::now() < end) { }
+    });
+    csp::schedule();
+
+    CHECK_GE(slept_ns.load(), int64_t(5'000'000));
+    CHECK_LT(slept_ns.load(), std::chrono::nanoseconds(spin).count() / 2);
+    auto stats = csp::get_runtime_stats();
+    CHECK_GE(stats.remote_timer_fires, 1u);
+    uint64_t fired = 0;
+    for (auto n : stats.timer_lateness) fired += n;
+    CHECK_GE(fired, 1u);
+
+    csp::shutdown_runtime();
+}
+
 // ---------------------------------------------------------------------------
 // Volume tests
 // ---------------------------------------------------------------------------
@@ -619,3 +1323,5 @@ TEST_CASE("MN Volume - SpawnDuringExecution") {
 
     csp::shutdown_runtime();
 }
+
+#endif // !CSP_SINGLE_THREADED
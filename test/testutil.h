@@ -13,6 +13,23 @@ int csp__internal__channel_count(int endpt);
 
 class RunScope;
 
+// Counts the heap allocations made on this OS thread while alive
+// (allocs.cc).
+class AllocCounter {
+public:
+    AllocCounter();
+    ~AllocCounter();
+
+    AllocCounter(AllocCounter const &) = delete;
+    AllocCounter & operator=(AllocCounter const &) = delete;
+
+    long count() const { return count_; }
+
+private:
+    long count_ = 0;
+    long * prev_;
+};
+
 class RunStats {
 public:
     RunStats() {
@@ -3,6 +3,8 @@
 #include <doctest/doctest.h>
 
 #include <csp/microthread.h>
+#include <csp/scheduler.h>
+#include <csp/timer.h>
 
 #include <algorithm>
 #include <stdexcept>
@@ -132,3 +134,210 @@ TEST_CASE("Thread - SpawnMany") {
     CHECK_EQ(0, csp__internal__channel_count(0));
     CHECK_EQ(0, csp__internal__channel_count(1));
 }
+
+TEST_CASE("Thread - BlockingInline") {
+    int result = 0;
+    csp::spawn([&]{
+        result = csp::blocking([]{ return 42; });
+    });
+
+    while (csp_run()) { }
+
+    CHECK_EQ(42, result);
+}
+
+TEST_CASE("Thread - EarliestDeadlineFirst") {
+    using namespace std::chrono_literals;
+
+    csp::runtime_options opts;
+    opts.num_procs = 1;
+    opts.policy = csp::sched_policy::edf;
+    csp::init_runtime(opts);
+
+    std::string trace;
+    auto now = csp::clock::now();
+    auto wake = now + 5ms;
+
+    // Everyone wakes at the same instant; EDF decides who runs first.
+    auto spawn_with = [&](char name, csp::clock::time_point const * deadline) {
+        csp::spawn([&, name, deadline]{
+            if (deadline) csp::set_deadline(*deadline);
+            csp::sleep_until(wake);
+            trace += name;
+        });
+    };
+    auto a = now + 30ms, b = now + 10ms, d = now + 20ms, e = now - 1ms;
+    spawn_with('A', &a);
+    spawn_with('B', &b);
+    spawn_with('C', nullptr);
+    spawn_with('D', &d);
+    spawn_with('E', &e);
+
+    while (csp_run()) { }
+
+    CHECK_EQ(std::string("EBDAC"), trace);
+    auto stats = csp::get_runtime_stats();
+    CHECK_EQ(4, stats.deadline_dispatches);
+    CHECK_EQ(1, stats.deadline_misses);
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("Thread - DeadlineSleeper") {
+    using namespace std::chrono_literals;
+
+    csp::runtime_options opts;
+    opts.num_procs = 1;
+    opts.policy = csp::sched_policy::edf;
+    csp::init_runtime(opts);
+
+    // EDF always has a yielding spinner to pick, but the most urgent
+    // microthread is asleep: its timer must still fire.
+    auto start = csp::clock::now();
+    auto give_up = start + 5s;
+    bool stop = false;
+    csp::clock::duration took{};
+    csp::spawn([&] {
+        csp::set_deadline(start + 2ms);
+        csp::sleep(1ms);
+        took = csp::clock::now() - start;
+        stop = true;
+    });
+    for (int i = 0; i < 2; ++i) {
+        csp::spawn([&] {
+            csp::set_deadline(start + 1s);
+            while (!stop && csp::clock::now() < give_up) {
+                csp_yield();
+            }
+        });
+    }
+    while (csp_run()) { }
+
+    CHECK_LT(took, 1s);
+
+    csp::shutdown_runtime();
+}
+
+TEST_CASE("Thread - LifoSleeper") {
+    using namespace std::chrono_literals;
+
+    csp::runtime_options opts;
+    opts.num_procs = 1;
+    opts.policy = csp::sched_policy::lifo;
+    csp::init_runtime(opts);
+
+    // Each wakeup of a ping-pong pair runs next, so the queue never comes
+    // round to the sentinel; a sleeper's timer must fire all the same.
+    auto start = csp::clock::now();
+    auto give_up = start + 5s;
+    bool stop = false;
+    csp::clock::duration took{};
+    csp::spawn([&] {
+        csp::sleep(1ms);
+        took = csp::clock::now() - start;
+        stop = true;
+    });
+    csp::channel<int> ping, pong;
+    csp::spawn([&, r = --ping, w = ++pong] {
+        for (int v; r >> v;) {
+            w << v;
+        }
+    });
+    csp::spawn([&, w = ++ping, r = --pong] {
+        for (int v = 0; !stop && csp::clock::now() < give_up; r >> v) {
+            w << v;
+        }
+    });
+    ping.release();
+    pong.release();
+    while (csp_run()) { }
+
+    CHECK_LT(took, 1s);
+
+    csp::shutdown_runtime();
+}
+
+namespace {
+
+    // Records the order in which microthreads (tagged by deadline) are
+    // pushed, on top of a built-in policy.
+    template <typename Base>
+    struct push_recorder : Base {
+        std::string pushes;
+        void notify(csp::run_queue_event e, csp::task t) override {
+            if (e == csp::run_queue_event::push) {
+                pushes += char(t.deadline_ns());
+            }
+        }
+    };
+
+    template <typename Policy>
+    void check_wake_order(bool reversed) {
+        using namespace std::chrono_literals;
+
+        auto policy = std::make_shared<push_recorder<Policy>>();
+        csp::runtime_options opts;
+        opts.num_procs = 1;
+        opts.queue_policy = policy;
+        csp::init_runtime(opts);
+
+        // Everyone wakes at the same instant; the policy decides who
+        // runs first relative to the order they were queued in.
+        std::string trace;
+        auto wake = csp::clock::now() + 5ms;
+        for (char name : std::string("ABCD")) {
+            csp::spawn([&, name] {
+                csp_set_deadline(name);     // Just a tag; fifo/lifo ignore it.
+                csp::sleep_until(wake);
+                trace += name;
+            });
+        }
+        while (csp_run()) { }
+
+        REQUIRE_EQ(4u, policy->pushes.size());
+        auto expected = policy->pushes;
+        if (reversed) {
+            std::reverse(expected.begin(), expected.end());
+        }
+        CHECK_EQ(expected, trace);
+
+        csp::shutdown_runtime();
+    }
+
+}
+
+TEST_CASE("Thread - RunQueuePolicy") {
+    check_wake_order<csp::fifo_policy>(false);
+    check_wake_order<csp::lifo_policy>(true);
+}
+
+TEST_CASE("Thread - SingleThreadedRuntime") {
+    csp::runtime_options opts;
+    opts.num_procs = 2;
+    opts.single_threaded = true;
+    CHECK_THROWS_AS(csp::init_runtime(opts), csp::microthread_error);
+
+    opts.num_procs = 0;
+    csp::init_runtime(opts);
+
+    csp::channel<int> ch;
+    int sum = 0;
+    csp::spawn([w = ++ch] {
+        for (int i = 0; i < 100; ++i) {
+            w << i;
+            csp_yield();
+        }
+    });
+    csp::spawn([&, r = --ch] {
+        csp::sleep(std::chrono::milliseconds(1));
+        for (int v; r >> v;) {
+            sum += v;
+        }
+    });
+    csp::schedule();
+
+    CHECK_EQ(4950, sum);
+    CHECK_THROWS_AS(csp::create_pool("st"), csp::microthread_error);
+
+    csp::shutdown_runtime();
+}
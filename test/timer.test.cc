@@ -3,6 +3,10 @@
 
 #include <csp/timer.h>
 
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
 using namespace csp;
 using namespace std::chrono_literals;
 
@@ -92,6 +96,223 @@ TEST_CASE("Timer - TickCancellation") {
     // If the tick microthread didn't exit, schedule() would hang.
 }
 
+TEST_CASE("Timer - TimeoutOperand") {
+    RunStats stats;
+
+    writer<int> idle_writer;
+    channel<int> ch;
+    int timed_out = 0, delivered = 0, preferred = 0, val = 0;
+    clock::duration waited{};
+
+    stats.spawn([w = +ch]{
+        csp::sleep(5ms);
+        w << 42;
+        w << 43;
+    });
+
+    stats.spawn([&, idle = --idle_writer, r = -ch]{
+        auto start = clock::now();
+        int n = 0;
+        timed_out = alt(idle >> n, csp::timeout(5ms));
+        waited = clock::now() - start;
+
+        // The channel wins; its timer is cancelled, not left to fire
+        // into a later alt.
+        delivered = alt(r >> val, csp::timeout(1s));
+
+        // prialt prefers a ready channel to a timeout that has passed.
+        csp::sleep(10ms);
+        preferred = prialt(r >> val, csp::timeout(0ms));
+    });
+
+    ch.release();
+    csp::schedule();
+    idle_writer = {};
+    CHECK_EQ(2, timed_out);
+    CHECK_GE(waited, 5ms);
+    CHECK_EQ(1, delivered);
+    CHECK_EQ(1, preferred);
+    CHECK_EQ(43, val);
+}
+
+TEST_CASE("Timer - AfterCancellation") {
+    RunStats stats;
+
+    // Dropped long timers must free their producers now, not at the
+    // deadline, or schedule() would wait out the hour.
+    auto start = clock::now();
+    stats.spawn([]{
+        for (int i = 0; i < 100; ++i) {
+            auto timeout = csp::after(1h);
+        }
+        auto ticker = csp::tick(1h);
+    });
+
+    csp::schedule();
+    CHECK_LT(clock::now() - start, 10s);
+}
+
+TEST_CASE("Timer - SharedTick") {
+    RunStats stats;
+
+    // Subscribers share one producer, so their ticks coincide; a
+    // subscriber that never reads doesn't stall them.
+    constexpr int N = 50;
+    std::mutex mu;
+    std::vector<clock::time_point> seen;
+    auto start = clock::now();
+    clock::duration took{};
+
+    auto lagger = csp::shared_tick(10ms);
+    for (int i = 0; i < N; ++i) {
+        stats.spawn([&]{
+            auto ticker = csp::shared_tick(10ms);
+            for (int k = 0; k < 3; ++k) {
+                auto tp = ticker.read();
+                std::lock_guard<std::mutex> lk(mu);
+                seen.push_back(tp);
+            }
+            std::lock_guard<std::mutex> lk(mu);
+            took = std::max(took, clock::now() - start);
+        });
+    }
+
+    stats.spawn([&]{
+        csp::sleep(CSP_TEST_SANITIZER ? 400ms : 200ms);
+        lagger = {};
+    });
+
+    csp::schedule();
+    REQUIRE_EQ(size_t(3 * N), seen.size());
+    std::sort(seen.begin(), seen.end());
+    auto distinct = std::unique(seen.begin(), seen.end()) - seen.begin();
+    CHECK_LE(distinct, 6);
+    CHECK_LT(took, CSP_TEST_SANITIZER ? 400ms : 200ms);
+}
+
+TEST_CASE("Timer - CoarseNow") {
+    RunStats stats;
+
+    // Outside a microthread it's the precise clock.
+    auto before = clock::now();
+    CHECK_GE(clock::coarse_now(), before);
+
+    bool never_ahead = true, refreshed = false;
+    stats.spawn([&]{
+        // Read coarse_now() first: the operands of <= are unsequenced, and
+        // with no round under way it's the precise clock itself.
+        auto start = clock::now();
+        auto coarse = clock::coarse_now();
+        never_ahead = coarse <= clock::now();
+        csp::sleep(5ms);
+        // The round that resumed us started after the sleep ended.
+        coarse = clock::coarse_now();
+        refreshed = coarse >= start + 5ms;
+        never_ahead = never_ahead && coarse <= clock::now();
+    });
+
+    csp::schedule();
+    CHECK(never_ahead);
+    CHECK(refreshed);
+}
+
+TEST_CASE("Timer - CoarseNowWhileChaining") {
+    // EDF switches between deadline spinners without ever returning to
+    // the scheduler loop, yet coarse_now() must keep up.
+    runtime_options opts;
+    opts.num_procs = 1;
+    opts.policy = sched_policy::edf;
+    init_runtime(opts);
+
+    auto start = clock::now();
+    clock::duration lag{};
+    for (int i = 0; i < 2; ++i) {
+        spawn([&] {
+            set_deadline(start + 1s);
+            sleep_until(start + 1ms);
+            while (clock::now() < start + 20ms) {
+                lag = std::max<clock::duration>(lag, clock::now() - clock::coarse_now());
+                csp_yield();
+            }
+        });
+    }
+    while (csp_run()) { }
+
+    CHECK_LT(lag, 5ms);
+
+    shutdown_runtime();
+}
+
+TEST_CASE("Timer - VirtualTime") {
+    // Hours of sleeps finish at once, in deadline order, on one processor
+    // and (where there is an M:N mode) across several.
+#if CSP_SINGLE_THREADED
+    std::vector<int> proc_counts{1};
+#else
+    std::vector<int> proc_counts{1, 3};
+#endif
+    for (int procs : proc_counts) {
+        runtime_options opts;
+        opts.num_procs = procs;
+        opts.virtual_time = true;
+        init_runtime(opts);
+
+        std::mutex mu;
+        std::vector<int> order;
+        auto start = clock::now();
+        auto wall = std::chrono::steady_clock::now();
+        for (int i : {3, 1, 2}) {
+            spawn([&, i] {
+                csp::sleep(i * 1h);
+                std::lock_guard<std::mutex> lk(mu);
+                order.push_back(i);
+            });
+        }
+        csp::schedule();
+
+        CHECK_EQ(std::vector<int>{1, 2, 3}, order);
+        CHECK_GE(clock::now() - start, 3h);
+        CHECK_LT(std::chrono::steady_clock::now() - wall, 10s);
+        shutdown_runtime();
+    }
+}
+
+TEST_CASE("Timer - Slack") {
+    // Sleeps staggered across one slack window wake together, never early
+    // and at most a window late; a zero per-sleep slack stays exact.
+    runtime_options opts;
+    opts.num_procs = 1;
+    opts.timer_slack = 20ms;
+    init_runtime(opts);
+
+    constexpr int N = 40;
+    auto before = get_runtime_stats().timer_wakeups;
+    auto start = clock::now();
+    bool early = false;
+    auto latest = clock::duration::zero(), exact_late = clock::duration::max();
+    for (int i = 0; i < N; ++i) {
+        spawn([&, i] {
+            auto deadline = start + i * 250us;
+            csp::sleep_until(deadline);
+            auto late = clock::now() - deadline;
+            early = early || late < 0ns;
+            latest = std::max(latest, late);
+        });
+    }
+    spawn([&] {
+        auto deadline = start + 3ms;
+        csp::sleep_until(deadline, 0ns);
+        exact_late = clock::now() - deadline;
+    });
+    csp::schedule();
+
+    CHECK_FALSE(early);
+    CHECK_LT(latest, 40ms);
+    CHECK_LT(exact_late, 15ms);
+    CHECK_LE(get_runtime_stats().timer_wakeups - before, 4u);
+    shutdown_runtime();
+}
+
 TEST_CASE("Timer - MultipleTimersOrdering") {
     RunStats stats;
 
@@ -129,3 +350,45 @@ TEST_CASE("Timer - TimeoutPattern") {
     CHECK_EQ(1, which_result);
     CHECK_EQ(42, val);
 }
+
+TEST_CASE("Timer - WheelOrdering") {
+    // A 1ns tick shrinks the wheel's range to ~17ms, so the longer sleeps
+    // start in the far-future heap and every level cascades.
+    runtime_options opts;
+    opts.num_procs = 1;
+    opts.timer_resolution = 1ns;
+    init_runtime(opts);
+
+    constexpr int N = 200;
+    std::vector<clock::time_point> woke_for;
+    bool early = false;
+    auto start = clock::now();
+    for (int i = 0; i < N; ++i) {
+        auto deadline = start + std::chrono::microseconds((i * 7919) % 60'000);
+        spawn([&, deadline] {
+            sleep_until(deadline);
+            early = early || clock::now() < deadline;
+            woke_for.push_back(deadline);
+        });
+    }
+    while (csp_run()) { }
+
+    CHECK_FALSE(early);
+    REQUIRE_EQ(size_t(N), woke_for.size());
+    CHECK(std::is_sorted(woke_for.begin(), woke_for.end()));
+
+    shutdown_runtime();
+
+    // A coarse tick rounds deadlines up, never down.
+    opts.timer_resolution = 5ms;
+    init_runtime(opts);
+    auto t0 = clock::now();
+    clock::duration slept{};
+    spawn([&] {
+        sleep(1ms);
+        slept = clock::now() - t0;
+    });
+    while (csp_run()) { }
+    CHECK_GE(slept, 1ms);
+    shutdown_runtime();
+}